@@ -0,0 +1,66 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#include <algorithm>
+#include "AreaRoutes.h"
+
+AreaRoutes *AreaRoutes::instance = nullptr;
+int AreaRoutes::numUsers = 0;
+
+const AreaRoutes *AreaRoutes::acquire(const RoutingEngine *engine, int areaSize)
+{
+    if (!instance)
+        instance = new AreaRoutes(engine, areaSize);
+    numUsers++;
+    return instance;
+}
+
+void AreaRoutes::release()
+{
+    if (numUsers > 0 && --numUsers == 0) {
+        delete instance;
+        instance = nullptr;
+    }
+}
+
+AreaRoutes::AreaRoutes(const RoutingEngine *engine, int areaSize) :
+    areaSize(areaSize), numNodes(engine->getNumNodes())
+{
+    nodeAreas.resize(numNodes);
+    for (int i = 0; i < numNodes; i++) {
+        nodeAreas[i] = engine->getAddress(i) / areaSize;
+        numAreas = std::max(numAreas, nodeAreas[i] + 1);
+    }
+
+    // members grouped by area (counting sort, so ascending within an area)
+    memberOffsets.assign(numAreas + 1, 0);
+    for (int i = 0; i < numNodes; i++)
+        memberOffsets[nodeAreas[i] + 1]++;
+    for (int area = 0; area < numAreas; area++)
+        memberOffsets[area + 1] += memberOffsets[area];
+    members.resize(numNodes);
+    localIndices.resize(numNodes);
+    std::vector<int> fill(memberOffsets.begin(), memberOffsets.end() - 1);
+    for (int i = 0; i < numNodes; i++) {
+        int area = nodeAreas[i];
+        localIndices[i] = fill[area] - memberOffsets[area];
+        members[fill[area]++] = i;
+    }
+
+    areaNextHops.assign((size_t)numAreas * numNodes, RoutingEngine::NO_ROUTE);
+    std::vector<int16_t> column;
+    std::vector<int> dests;
+    for (int area = 0; area < numAreas; area++) {
+        if (getNumAreaMembers(area) == 0)
+            continue;
+        dests.assign(getAreaMembers(area), getAreaMembers(area) + getNumAreaMembers(area));
+        engine->computeNextHopsToAny(dests, column);
+        std::copy(column.begin(), column.end(), areaNextHops.begin() + (size_t)area * numNodes);
+    }
+}
@@ -0,0 +1,78 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#ifndef __AREA_ROUTES_H
+#define __AREA_ROUTES_H
+
+#include <cstdint>
+#include <vector>
+#include "RoutingEngine.h"
+
+/**
+ * Routes towards areas, for hierarchical routing. Routers are grouped into
+ * areas of areaSize consecutive addresses (area = address / areaSize). For
+ * every area, one multi-source search over the reverse graph yields the
+ * next hop of every node towards the nearest member of the area; routers
+ * outside the area forward along these, so packets reach the area without
+ * loops, and are then routed on paths inside the area.
+ *
+ * There is a single instance per simulation run; Routing modules acquire it
+ * in initialization stage 0, copy their own entries in stage 1, and release
+ * it, so the numAreas x numNodes columns only exist during initialization.
+ */
+class AreaRoutes
+{
+  private:
+    int areaSize;
+    int numNodes;
+    int numAreas = 0;
+    std::vector<int> nodeAreas;        // node index -> area
+    std::vector<int> memberOffsets;    // area -> first position in members, size numAreas+1
+    std::vector<int> members;          // node indices, grouped by area, ascending within an area
+    std::vector<int> localIndices;     // node index -> position within its area's members
+    std::vector<int16_t> areaNextHops; // [area * numNodes + node] -> gate index
+
+    static AreaRoutes *instance;
+    static int numUsers;
+
+  protected:
+    AreaRoutes(const RoutingEngine *engine, int areaSize);
+
+  public:
+    /**
+     * Returns the shared instance, computing it from the given engine when
+     * called for the first time. Every call must be paired with release().
+     */
+    static const AreaRoutes *acquire(const RoutingEngine *engine, int areaSize);
+    static void release();
+
+    int getAreaSize() const { return areaSize; }
+    int getNumAreas() const { return numAreas; }
+
+    /** Area of every node, indexed by node index. */
+    const std::vector<int>& getNodeAreas() const { return nodeAreas; }
+
+    /**
+     * Node indices of the members of the area, and their number; together
+     * with getLocalIndices(), the arguments of
+     * RoutingEngine::computeNextHopsWithin().
+     */
+    const int *getAreaMembers(int area) const { return members.data() + memberOffsets[area]; }
+    int getNumAreaMembers(int area) const { return memberOffsets[area + 1] - memberOffsets[area]; }
+
+    /** Position of every node within the members of its own area, indexed by node index. */
+    const std::vector<int>& getLocalIndices() const { return localIndices; }
+
+    /** Next hop gate index from the node towards the area, or NO_ROUTE. */
+    int getNextHopToArea(int node, int area) const {
+        return areaNextHops[(size_t)area * numNodes + node];
+    }
+};
+
+#endif
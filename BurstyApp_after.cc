@@ -7,9 +7,24 @@
 // `license' for details on this and other legal matters.
 //
 
-#define FSM_DEBUG
+#include "FastMode.h"
+#ifndef FAST_MODE
+#define FSM_DEBUG  // logs every state transition
+#endif
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <omnetpp.h>
+#include "FlowStats.h"
 #include "Packet_m.h"
+#include "PacketPool.h"
+#include "PacketTrace.h"
+#include "RateMeter.h"
+#include "ResultStream.h"
+#include "SignalMask.h"
+#include "TrafficEngine.h"
 
 using namespace omnetpp;
 
@@ -26,6 +41,29 @@ class BurstyApp : public cSimpleModule
     cPar *burstTime;
     cPar *sendIATime;
     cPar *packetLengthBytes;
+    bool namePackets;       // format "pk-<src>-to-<dest>-#<n>" names
+    size_t packetPoolSize;  // 0 = no recycling of consumed packets
+    bool fastMode;          // no per-packet logging, bubbles, display updates
+    bool batchedBurst;      // draw all send times of a burst when it starts
+
+    // ✅ CHANGE: Random parameters are drawn through samplers, compiled to
+    // native RNG calls with nativeSamplers
+    // ✔️ IMPACT: No NED expression evaluation per packet
+    TrafficSampler sleepTimeSampler;
+    TrafficSampler burstTimeSampler;
+    TrafficSampler sendIaTimeSampler;
+    TrafficSampler packetLengthSampler;
+    bool useTrafficMatrix = false;  // destinations drawn from destinationSampler
+    DestinationSampler destinationSampler;
+
+    // traceFile: replay of this node's records instead of bursts
+    PacketTrace *trace = nullptr;
+    PacketTrace::Cursor traceCursor;
+    PacketTrace::Record pendingRecord;  // next record to send
+    simtime_t pendingTime;              // its send time
+    double lastTraceTime = -1e300;      // time in the last record, for checking the order
+    simtime_t traceTimeOffset;
+    cMessage *replayTimer = nullptr;
 
     // state
     cFSM fsm;
@@ -39,27 +77,70 @@ class BurstyApp : public cSimpleModule
     int pkCounter;
     cMessage *startStopBurst = nullptr;
     cMessage *sendMessage = nullptr;
+    simtime_t burstEnd;
+    std::vector<simtime_t> sendSchedule;  // batchedBurst: send times in the current burst
+    size_t nextSend = 0;
     int numSent;
     int numReceived;
 
+    // ✅ CHANGE: Throughput accounting -- totals, and per-interval counters in
+    // ring buffers for windowed and peak rates
+    // ✔️ IMPACT: Offered/delivered load as scalars, without exporting vectors
+    int64_t bytesSent;
+    int64_t bytesReceived;
+    RateMeter sentMeter;
+    RateMeter receivedMeter;
+    cMessage *rateSampleTimer = nullptr;  // recordRateVectors: one sample per interval
+    cOutVector sentRateVector;
+    cOutVector receivedRateVector;
+
     // signals
+    enum { END_TO_END_DELAY = 1 << 0, HOP_COUNT = 1 << 1, SOURCE_ADDRESS = 1 << 2 };
+    bool collectStats;
+    unsigned signalMask;  // signals enabled at initialization
     simsignal_t endToEndDelaySignal;
     simsignal_t hopCountSignal;
     simsignal_t sourceAddressSignal;
 
+    // statisticsMode = "aggregated"/"both": per-flow summaries recorded at
+    // finish(), keyed by source address (this node is the destination)
+    struct FlowRecord {
+        FlowStats delay;
+        FlowStats hopCount;
+    };
+    bool aggregateFlows;
+
+    // resultStreamFile: per-packet values written to the run's columnar file
+    ResultStream *resultStream = nullptr;
+    int streamSourceId;
+    int streamMetricIds[3];
+    std::unordered_map<int, FlowRecord> flows;
+
   public:
     virtual ~BurstyApp();
 
   protected:
+    virtual Packet *allocatePacket(const char *name);
+    virtual void recyclePacket(Packet *pk);
+    // timestamp set by the sender, or the creation time for senders that don't set it (App)
+    simtime_t getSendTime(Packet *pk) const { return pk->getTimestamp() != SIMTIME_ZERO ? pk->getTimestamp() : pk->getCreationTime(); }
+
     // redefined cSimpleModule methods
     virtual void initialize() override;
     virtual void handleMessage(cMessage *msg) override;
     virtual void refreshDisplay() const override;
+    virtual void finish() override;
 
     // new methods
     virtual void processTimer(cMessage *msg);
     virtual void processPacket(Packet *pk);
     virtual void generatePacket();
+    virtual void sendPacket(int destAddress, int64_t byteLength);
+    virtual bool fetchTraceRecord();
+    virtual void replayTraceRecords();
+    virtual void scheduleBurst();
+    virtual void sendScheduledPacket();
+    virtual void sampleRates();
 };
 
 Define_Module(BurstyApp);
@@ -68,18 +149,29 @@ BurstyApp::~BurstyApp()
 {
     cancelAndDelete(startStopBurst);
     cancelAndDelete(sendMessage);
+    cancelAndDelete(replayTimer);
+    cancelAndDelete(rateSampleTimer);
+    if (trace)
+        PacketTrace::release();
+    if (packetPoolSize > 0)
+        PacketPool::release();
+    if (resultStream)
+        ResultStream::release();
 }
 
 void BurstyApp::initialize()
 {
     numSent = numReceived = 0;
+    bytesSent = bytesReceived = 0;
     // ✅ RETAINED: Collects statistics flag for monitoring
     // ✔️ IMPACT: Displays the `collectStats` value in the runtime GUI
     // ✔️ IMPACT: Providing real-time feedback on whether statistics are being collected
-    bool collectStats = par("collectStatistics").boolValue();
+    collectStats = par("collectStatistics").boolValue();
     WATCH(collectStats);
     WATCH(numSent);
     WATCH(numReceived);
+    WATCH(bytesSent);
+    WATCH(bytesReceived);
 
     fsm.setName("fsm");
 
@@ -89,22 +181,130 @@ void BurstyApp::initialize()
     burstTime = &par("burstTime");
     sendIATime = &par("sendIaTime");
     packetLengthBytes = &par("packetLength");
+    fastMode = FAST_MODE_FORCED || par("fastMode").boolValue();
+    batchedBurst = par("batchedBurst").boolValue();
+
+    TrafficSampler *samplers[] = { &sleepTimeSampler, &burstTimeSampler, &sendIaTimeSampler, &packetLengthSampler };
+    cPar *samplerPars[] = { sleepTime, burstTime, sendIATime, packetLengthBytes };
+    bool nativeSamplers = par("nativeSamplers").boolValue();
+    for (int i = 0; i < 4; i++) {
+        if (!nativeSamplers)
+            samplers[i]->setParameter(samplerPars[i]);
+        else {
+            if (!samplers[i]->compile(samplerPars[i], getRNG(0), par("sampleBlockSize").intValue()))
+                EV_WARN << "expression of " << samplerPars[i]->getName() << " not supported by the native samplers, evaluating the parameter\n";
+            EV_DETAIL << samplers[i]->str() << endl;
+        }
+    }
+
+    // ✅ CHANGE: Optional traffic matrix -- weighted destinations, drawn with
+    // an alias table instead of uniformly from destAddresses
+    // ✔️ IMPACT: Realistic src->dst demand at O(1) per packet
+    std::string trafficMatrix = par("trafficMatrix").stdstringValue();
+    const char *trafficMatrixFile = par("trafficMatrixFile").stringValue();
+    if (*trafficMatrixFile) {
+        std::ifstream in(trafficMatrixFile);
+        if (!in)
+            throw cRuntimeError("Cannot read traffic matrix file '%s'", trafficMatrixFile);
+        std::stringstream content;
+        content << in.rdbuf();
+        trafficMatrix += "\n" + content.str();
+    }
+    useTrafficMatrix = trafficMatrix.find_first_not_of(" \t\r\n") != std::string::npos;
+    if (useTrafficMatrix) {
+        std::vector<int> dests;
+        std::vector<double> weights;
+        parseTrafficMatrix(trafficMatrix.c_str(), myAddress, dests, weights);
+        if (!dests.empty())
+            destinationSampler.build(dests, weights);
+        EV_DETAIL << "traffic matrix row of address " << myAddress << " has " << dests.size() << " destinations\n";
+    }
+
+    // ✅ CHANGE: Packet names are optional, and consumed packets are recycled
+    // ✔️ IMPACT: No snprintf, name copy, new and delete per packet in batch runs
+    const char *packetNames = par("packetNames").stringValue();
+    namePackets = !strcmp(packetNames, "always") || (!strcmp(packetNames, "auto") && getEnvir()->isGUI());
+    packetPoolSize = par("packetPoolSize").intValue();
+    const char *recordEventlog = getEnvir()->getConfig()->getConfigValue("record-eventlog");
+    if (packetPoolSize > 0 && (getEnvir()->isGUI() || (recordEventlog && !strcmp(recordEventlog, "true")))) {
+        // recycled packets keep their message IDs, which must be unique there
+        EV_WARN << "packetPoolSize ignored: no packet recycling with a GUI or an eventlog\n";
+        packetPoolSize = 0;
+    }
+    if (packetPoolSize > 0)
+        PacketPool::acquire(packetPoolSize);
 
     endToEndDelaySignal = registerSignal("endToEndDelay");
     hopCountSignal = registerSignal("hopCount");
     sourceAddressSignal = registerSignal("sourceAddress");
+    static const char *const signalNames[] = { "endToEndDelay", "hopCount", "sourceAddress" };
+    const char *statisticsMode = par("statisticsMode").stringValue();
+    aggregateFlows = collectStats && strcmp(statisticsMode, "signals") != 0;
+    bool emitSignals = collectStats && strcmp(statisticsMode, "aggregated") != 0;
+    signalMask = resolveSignalMask(emitSignals, par("enabledSignals").stringValue(), signalNames, 3);
+    const char *resultStreamFile = par("resultStreamFile").stringValue();
+    if (collectStats && *resultStreamFile) {
+        resultStream = ResultStream::acquire(resultStreamFile);
+        streamSourceId = resultStream->addSource(getFullPath().c_str());
+        for (int i = 0; i < 3; i++)
+            streamMetricIds[i] = resultStream->getMetricId(signalNames[i]);
+    }
+
+    double rateMeterInterval = par("rateMeterInterval").doubleValue();
+    if (rateMeterInterval <= 0)
+        throw cRuntimeError("rateMeterInterval must be positive");
+    int rateMeterBuckets = par("rateMeterBuckets").intValue();
+    if (rateMeterBuckets < 2)
+        throw cRuntimeError("rateMeterBuckets must be at least 2");
+    sentMeter.configure(rateMeterInterval, rateMeterBuckets);
+    receivedMeter.configure(rateMeterInterval, rateMeterBuckets);
+    if (collectStats && par("recordRateVectors").boolValue()) {
+        sentRateVector.setName("sentRate");
+        sentRateVector.setUnit("bps");
+        receivedRateVector.setName("receivedRate");
+        receivedRateVector.setUnit("bps");
+        rateSampleTimer = new cMessage("rateSampleTimer");
+        scheduleAt(rateMeterInterval, rateSampleTimer);
+    }
 
     pkCounter = 0;
     WATCH(pkCounter);  // always put watches in initialize(), NEVER in handleMessage()
     startStopBurst = new cMessage("startStopBurst");
     sendMessage = new cMessage("sendMessage");
 
+    // ✅ CHANGE: Trace replay -- the node's records are streamed from the
+    // memory-mapped trace, with one self-timer
+    // ✔️ IMPACT: Captured traffic of any size drives the network; only the
+    // replayed pages of the trace are resident
+    const char *traceFile = par("traceFile").stringValue();
+    if (*traceFile) {
+        std::string error;
+        trace = PacketTrace::acquire(traceFile, error);
+        if (!trace)
+            throw cRuntimeError("Cannot replay packet trace: %s", error.c_str());
+        traceCursor = trace->getCursor(myAddress);
+        traceTimeOffset = par("traceTimeOffset").doubleValue();
+        EV << "replaying " << traceCursor.getRemaining() << " records of " << trace->getNumRecords() << " from " << traceFile << endl;
+        replayTimer = new cMessage("replayTimer");
+        if (fetchTraceRecord())
+            scheduleAt(pendingTime, replayTimer);
+        return;
+    }
+
+    if (useTrafficMatrix && destinationSampler.isEmpty())
+        return;  // no demand from this node in the traffic matrix
     scheduleAt(0, startStopBurst);
 }
 
 void BurstyApp::handleMessage(cMessage *msg)
 {
-    if (msg->isSelfMessage())
+    if (msg == replayTimer)
+        replayTraceRecords();
+    else if (msg == rateSampleTimer)
+        sampleRates();
+    else if (msg == sendMessage && batchedBurst)
+        sendScheduledPacket();  // bypasses the FSM, the burst is already planned
+    else if (msg->isSelfMessage())
         processTimer(msg);
     else
         processPacket(check_and_cast<Packet *>(msg));
@@ -119,21 +319,26 @@ void BurstyApp::processTimer(cMessage *msg)
             break;
 
         case FSM_Enter(SLEEP):
-            d = sleepTime->doubleValue();
+            d = sleepTimeSampler.draw();
             scheduleAt(simTime() + d, startStopBurst);
 
-            EV << "sleeping for " << d << "s\n";
-            bubble("burst ended, sleeping");
-            getDisplayString().setTagArg("i", 1, "");
+            HOT_EV << "sleeping for " << d << "s\n";
+            if (!fastMode) {
+                bubble("burst ended, sleeping");
+                getDisplayString().setTagArg("i", 1, "");
+            }
             break;
 
         case FSM_Exit(SLEEP):
-            d = burstTime->doubleValue();
-            scheduleAt(simTime() + d, startStopBurst);
-
-            EV << "starting burst of duration " << d << "s\n";
-            bubble("burst started");
-            getDisplayString().setTagArg("i", 1, "yellow");
+            d = burstTimeSampler.draw();
+            burstEnd = simTime() + d;
+            scheduleAt(burstEnd, startStopBurst);
+
+            HOT_EV << "starting burst of duration " << d << "s\n";
+            if (!fastMode) {
+                bubble("burst started");
+                getDisplayString().setTagArg("i", 1, "yellow");
+            }
 
             if (msg != startStopBurst)
                 throw cRuntimeError("invalid event in state ACTIVE");
@@ -141,8 +346,12 @@ void BurstyApp::processTimer(cMessage *msg)
             break;
 
         case FSM_Enter(ACTIVE):
-            d = sendIATime->doubleValue();
-            EV << "next sending in " << d << "s\n";
+            if (batchedBurst) {
+                scheduleBurst();
+                break;
+            }
+            d = sendIaTimeSampler.draw();
+            HOT_EV << "next sending in " << d << "s\n";
 
             cancelEvent(sendMessage);  // ✅ Ensure clean scheduling
             scheduleAt(simTime() + d, sendMessage);
@@ -159,7 +368,7 @@ void BurstyApp::processTimer(cMessage *msg)
                 generatePacket();
 
                 cancelEvent(sendMessage);  // ✅ Cancel before rescheduling
-                scheduleAt(simTime() + sendIATime->doubleValue(), sendMessage);
+                scheduleAt(simTime() + sendIaTimeSampler.draw(), sendMessage);
                 // Remain in ACTIVE
             }
             else {
@@ -175,35 +384,197 @@ void BurstyApp::processTimer(cMessage *msg)
 
 void BurstyApp::generatePacket()
 {
-    int destAddress = destAddresses[intuniform(0, destAddresses.size()-1)];
+    int destAddress = useTrafficMatrix ? destinationSampler.draw(getRNG(0)) : destAddresses[intuniform(0, destAddresses.size()-1)];
+    sendPacket(destAddress, (int64_t)packetLengthSampler.draw());
+}
+
+void BurstyApp::sendPacket(int destAddress, int64_t byteLength)
+{
+    HOT_EV << "generating packet pk-" << myAddress << "-to-" << destAddress << "-#" << pkCounter << endl;
 
     char pkname[40];
-    snprintf(pkname, sizeof(pkname), "pk-%d-to-%d-#%d", myAddress, destAddress, pkCounter++);
-    EV << "generating packet " << pkname << endl;
+    if (namePackets)
+        snprintf(pkname, sizeof(pkname), "pk-%d-to-%d-#%d", myAddress, destAddress, pkCounter);
+    pkCounter++;
 
-    Packet *pk = new Packet(pkname);
-    pk->setByteLength(packetLengthBytes->intValue());
+    Packet *pk = allocatePacket(namePackets ? pkname : nullptr);
+    pk->setTimestamp();  // recycled packets keep their original creation time
+    pk->setByteLength(byteLength);
     pk->setSrcAddr(myAddress);
     pk->setDestAddr(destAddress);
     send(pk, "out");
+
+    numSent++;
+    bytesSent += byteLength;
+    sentMeter.record(simTime().dbl(), byteLength);
+}
+
+bool BurstyApp::fetchTraceRecord()
+{
+    if (!traceCursor.hasNext())
+        return false;
+    pendingRecord = traceCursor.next();
+    if (pendingRecord.time < lastTraceTime)
+        throw cRuntimeError("Records of address %d in the packet trace are not sorted by time", myAddress);
+    lastTraceTime = pendingRecord.time;
+    pendingTime = std::max(simTime(), simtime_t(pendingRecord.time) + traceTimeOffset);
+    return true;
+}
+
+void BurstyApp::replayTraceRecords()
+{
+    // every record that is due is sent in this event; records before the
+    // start of the simulation are sent at time 0
+    bool more;
+    do {
+        sendPacket(pendingRecord.dest, pendingRecord.length);
+    } while ((more = fetchTraceRecord()) && pendingTime <= simTime());
+    if (more)
+        scheduleAt(pendingTime, replayTimer);
+}
+
+void BurstyApp::scheduleBurst()
+{
+    // ✅ CHANGE: Send times of the whole burst are drawn up front, in the
+    // same way the per-packet rescheduling would draw them: one interval
+    // after every packet, until the end of the burst
+    // ✔️ IMPACT: One scheduleAt() per packet, no cancelEvent() and no FSM dispatch
+    sendSchedule.clear();
+    for (simtime_t t = simTime() + sendIaTimeSampler.draw(); t < burstEnd; t += sendIaTimeSampler.draw())
+        sendSchedule.push_back(t);
+    HOT_EV << "burst of " << sendSchedule.size() + 1 << " packets scheduled\n";
+
+    nextSend = 0;
+    cancelEvent(sendMessage);
+    if (!sendSchedule.empty())
+        scheduleAt(sendSchedule[0], sendMessage);
+
+    generatePacket();  // first packet at the start of the burst
+}
+
+void BurstyApp::sendScheduledPacket()
+{
+    generatePacket();
+    if (++nextSend < sendSchedule.size())
+        scheduleAt(sendSchedule[nextSend], sendMessage);
+}
+
+void BurstyApp::sampleRates()
+{
+    // the sample of an interval is recorded at its end
+    double now = simTime().dbl();
+    sentMeter.advance(now);
+    receivedMeter.advance(now);
+    sentRateVector.record(sentMeter.getLastIntervalRate() * 8);
+    receivedRateVector.record(receivedMeter.getLastIntervalRate() * 8);
+    scheduleAt(simTime() + sentMeter.getInterval(), rateSampleTimer);
 }
 
 void BurstyApp::processPacket(Packet *pk)
 {
-    EV << "received packet " << pk->getName() << " after " << pk->getHopCount() << "hops" << endl;
+    HOT_EV << "received packet " << pk->getName() << " from " << pk->getSrcAddr() << " after " << pk->getHopCount() << "hops" << endl;
 
-    if (par("collectStatistics").boolValue()) {
+    if (signalMask) {
         // ✅ CHANGE : Collects end-to-end delay, hop count, and source address
         // ✔️ IMPACT: Enables the collection of useful metrics for analyzing packet transmission and network performance
-        emit(endToEndDelaySignal, simTime() - pk->getCreationTime());
-        emit(hopCountSignal, pk->getHopCount());
-        emit(sourceAddressSignal, pk->getSrcAddr());
+        // ✅ CHANGE: Flags resolved at initialization, and no emit() without listeners
+        // ✔️ IMPACT: No par() lookup and no signal dispatch per received packet
+        if ((signalMask & END_TO_END_DELAY) && mayHaveListeners(endToEndDelaySignal))
+            emit(endToEndDelaySignal, simTime() - getSendTime(pk));
+        if ((signalMask & HOP_COUNT) && mayHaveListeners(hopCountSignal))
+            emit(hopCountSignal, pk->getHopCount());
+        if ((signalMask & SOURCE_ADDRESS) && mayHaveListeners(sourceAddressSignal))
+            emit(sourceAddressSignal, pk->getSrcAddr());
+    }
+    if (resultStream) {
+        // ✅ CHANGE: Values streamed into a columnar binary file
+        // ✔️ IMPACT: The analysis maps the file directly; no .vec -> CSV export step
+        double now = simTime().dbl();
+        resultStream->record(now, streamSourceId, streamMetricIds[0], (simTime() - getSendTime(pk)).dbl());
+        resultStream->record(now, streamSourceId, streamMetricIds[1], pk->getHopCount());
+        resultStream->record(now, streamSourceId, streamMetricIds[2], pk->getSrcAddr());
+    }
+    if (aggregateFlows) {
+        // ✅ CHANGE: Delay and hop count summarized per flow in fixed-size records
+        // ✔️ IMPACT: Results are a few scalars per flow instead of vectors with an entry per packet
+        FlowRecord& flow = flows[pk->getSrcAddr()];
+        flow.delay.collect((simTime() - getSendTime(pk)).dbl());
+        flow.hopCount.collect(pk->getHopCount());
     }
 
     numReceived++;
+    bytesReceived += pk->getByteLength();
+    receivedMeter.record(simTime().dbl(), pk->getByteLength());
+    recyclePacket(pk);
+}
+
+Packet *BurstyApp::allocatePacket(const char *name)
+{
+    Packet *pk = packetPoolSize > 0 ? PacketPool::get() : nullptr;
+    if (!pk)
+        return new Packet(name);
+    take(pk);
+    pk->setName(name);
+    return pk;
+}
+
+void BurstyApp::recyclePacket(Packet *pk)
+{
+    if (packetPoolSize > 0) {
+        drop(pk);
+        if (PacketPool::put(pk))
+            return;
+    }
     delete pk;
 }
 
+void BurstyApp::finish()
+{
+    if (collectStats) {
+        // rates in bits/s; the windowed and peak rates only count complete intervals
+        double now = simTime().dbl();
+        sentMeter.advance(now);
+        receivedMeter.advance(now);
+        recordScalar("sent:packets", numSent);
+        recordScalar("sent:bytes", bytesSent, "B");
+        recordScalar("received:packets", numReceived);
+        recordScalar("received:bytes", bytesReceived, "B");
+        recordScalar("offeredLoad", now > 0 ? bytesSent * 8 / now : 0, "bps");
+        recordScalar("deliveredLoad", now > 0 ? bytesReceived * 8 / now : 0, "bps");
+        recordScalar("sentRate:window", sentMeter.getWindowRate() * 8, "bps");
+        recordScalar("sentRate:peak", sentMeter.getPeakRate() * 8, "bps");
+        recordScalar("sentRate:peakPackets", sentMeter.getPeakPacketRate(), "1/s");
+        recordScalar("receivedRate:window", receivedMeter.getWindowRate() * 8, "bps");
+        recordScalar("receivedRate:peak", receivedMeter.getPeakRate() * 8, "bps");
+        recordScalar("receivedRate:peakPackets", receivedMeter.getPeakPacketRate(), "1/s");
+    }
+
+    std::vector<int> sources;
+    for (const auto& entry : flows)
+        sources.push_back(entry.first);
+    std::sort(sources.begin(), sources.end());
+
+    char prefix[48], name[80];
+    for (int source : sources) {
+        const FlowRecord& flow = flows[source];
+        snprintf(prefix, sizeof(prefix), "flow[%d->%d]", source, myAddress);
+        auto record = [&](const char *suffix, double value, const char *unit) {
+            snprintf(name, sizeof(name), "%s:%s", prefix, suffix);
+            recordScalar(name, value, unit);
+        };
+        record("count", flow.delay.getCount(), nullptr);
+        record("delay:mean", flow.delay.getMean(), "s");
+        record("delay:stddev", flow.delay.getStddev(), "s");
+        record("delay:min", flow.delay.getMin(), "s");
+        record("delay:max", flow.delay.getMax(), "s");
+        record("delay:p50", flow.delay.getQuantile(0.5), "s");
+        record("delay:p95", flow.delay.getQuantile(0.95), "s");
+        record("delay:p99", flow.delay.getQuantile(0.99), "s");
+        record("hopCount:mean", flow.hopCount.getMean(), nullptr);
+        record("hopCount:max", flow.hopCount.getMax(), nullptr);
+    }
+}
+
 void BurstyApp::refreshDisplay() const
 {
     char txt[64];
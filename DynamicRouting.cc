@@ -0,0 +1,271 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#include <functional>
+#include <limits>
+#include <queue>
+#include "DynamicRouting.h"
+
+DynamicRouting *DynamicRouting::instance = nullptr;
+int DynamicRouting::numUsers = 0;
+
+static const double INF = std::numeric_limits<double>::infinity();
+
+typedef std::pair<double, int> HeapEntry;  // distance, node
+typedef std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> MinHeap;
+
+DynamicRouting::DynamicRouting(const RoutingEngine *engine) : engine(engine)
+{
+    numNodes = engine->getNumNodes();
+    int numLinks = engine->getNumLinks();
+    linkSource.resize(numLinks);
+    for (int node = 0; node < numNodes; node++)
+        for (int e = engine->getLinkBegin(node); e < engine->getLinkEnd(node); e++)
+            linkSource[e] = node;
+    linkUp.assign(numLinks, 1);
+    nodeUp.assign(numNodes, 1);
+    listeners.assign(numNodes, nullptr);
+    affectedStamp.assign(numNodes, 0);
+
+    size_t size = (size_t)numNodes * numNodes;
+    dist.assign(size, INF);
+    parentLink.assign(size, -1);
+    nextHops.assign(size, RoutingEngine::NO_ROUTE);
+    for (int source = 0; source < numNodes; source++)
+        computeTree(source);
+}
+
+DynamicRouting *DynamicRouting::acquire(const RoutingEngine *engine)
+{
+    if (!instance)
+        instance = new DynamicRouting(engine);
+    numUsers++;
+    return instance;
+}
+
+void DynamicRouting::release()
+{
+    if (--numUsers == 0) {
+        delete instance;
+        instance = nullptr;
+    }
+}
+
+void DynamicRouting::settle(int source, int node)
+{
+    // derive the next hop of a node from its parent link; the parent must
+    // already be settled
+    size_t row = (size_t)source * numNodes;
+    int link = parentLink[row + node];
+    int16_t gate = RoutingEngine::NO_ROUTE;
+    if (link != -1)
+        gate = linkSource[link] == source ? engine->getLinkGate(link) : nextHops[row + linkSource[link]];
+    if (nextHops[row + node] != gate) {
+        nextHops[row + node] = gate;
+        numNodesUpdated++;
+        if (listeners[source])
+            listeners[source]->nextHopChanged(engine->getAddress(node), gate);
+    }
+}
+
+void DynamicRouting::computeTree(int source)
+{
+    size_t row = (size_t)source * numNodes;
+    if (!nodeUp[source])
+        return;
+    dist[row + source] = 0;
+    MinHeap heap;
+    heap.push(HeapEntry(0, source));
+    while (!heap.empty()) {
+        HeapEntry top = heap.top();
+        heap.pop();
+        int node = top.second;
+        if (top.first > dist[row + node])
+            continue;
+        if (node != source)
+            settle(source, node);
+        for (int e = engine->getLinkBegin(node); e < engine->getLinkEnd(node); e++) {
+            if (!isUsable(e))
+                continue;
+            int neighbor = engine->getLinkTarget(e);
+            double d = top.first + engine->getLinkWeight(e);
+            if (d < dist[row + neighbor]) {
+                dist[row + neighbor] = d;
+                parentLink[row + neighbor] = e;
+                heap.push(HeapEntry(d, neighbor));
+            }
+        }
+    }
+}
+
+void DynamicRouting::linkRemoved(int link)
+{
+    int head = engine->getLinkTarget(link);
+    for (int source = 0; source < numNodes; source++) {
+        size_t row = (size_t)source * numNodes;
+        if (parentLink[row + head] != link)
+            continue;  // link not in this tree
+        numTreesRepaired++;
+
+        // collect the subtree below the link, and detach it
+        ++stamp;
+        std::vector<int> affected;
+        affected.push_back(head);
+        affectedStamp[head] = stamp;
+        for (size_t i = 0; i < affected.size(); i++) {
+            int node = affected[i];
+            for (int e = engine->getLinkBegin(node); e < engine->getLinkEnd(node); e++) {
+                int child = engine->getLinkTarget(e);
+                if (parentLink[row + child] == e && affectedStamp[child] != stamp) {
+                    affectedStamp[child] = stamp;
+                    affected.push_back(child);
+                }
+            }
+        }
+        for (int node : affected) {
+            dist[row + node] = INF;
+            parentLink[row + node] = -1;
+        }
+
+        // reattach: best usable link from the intact part of the tree, then
+        // Dijkstra restricted to the affected nodes
+        MinHeap heap;
+        for (int node : affected) {
+            for (int pos = engine->getInLinkBegin(node); pos < engine->getInLinkEnd(node); pos++) {
+                int e = engine->getInLink(pos);
+                int from = linkSource[e];
+                if (!isUsable(e) || affectedStamp[from] == stamp || dist[row + from] == INF)
+                    continue;
+                double d = dist[row + from] + engine->getLinkWeight(e);
+                if (d < dist[row + node]) {
+                    dist[row + node] = d;
+                    parentLink[row + node] = e;
+                }
+            }
+            if (dist[row + node] < INF)
+                heap.push(HeapEntry(dist[row + node], node));
+        }
+        while (!heap.empty()) {
+            HeapEntry top = heap.top();
+            heap.pop();
+            int node = top.second;
+            if (top.first > dist[row + node])
+                continue;
+            settle(source, node);
+            for (int e = engine->getLinkBegin(node); e < engine->getLinkEnd(node); e++) {
+                int neighbor = engine->getLinkTarget(e);
+                if (!isUsable(e) || affectedStamp[neighbor] != stamp)
+                    continue;
+                double d = top.first + engine->getLinkWeight(e);
+                if (d < dist[row + neighbor]) {
+                    dist[row + neighbor] = d;
+                    parentLink[row + neighbor] = e;
+                    heap.push(HeapEntry(d, neighbor));
+                }
+            }
+        }
+        for (int node : affected)
+            if (dist[row + node] == INF)
+                settle(source, node);  // now unreachable
+    }
+}
+
+void DynamicRouting::linkAdded(int link)
+{
+    if (!isUsable(link))
+        return;
+    int tail = linkSource[link];
+    int head = engine->getLinkTarget(link);
+    for (int source = 0; source < numNodes; source++) {
+        size_t row = (size_t)source * numNodes;
+        if (!nodeUp[source] || dist[row + tail] == INF)
+            continue;
+        double d = dist[row + tail] + engine->getLinkWeight(link);
+        if (d >= dist[row + head])
+            continue;  // does not shorten any path in this tree
+        numTreesRepaired++;
+
+        // propagate the improvement; only nodes whose distance decreases
+        // are visited
+        dist[row + head] = d;
+        parentLink[row + head] = link;
+        MinHeap heap;
+        heap.push(HeapEntry(d, head));
+        while (!heap.empty()) {
+            HeapEntry top = heap.top();
+            heap.pop();
+            int node = top.second;
+            if (top.first > dist[row + node])
+                continue;
+            settle(source, node);
+            for (int e = engine->getLinkBegin(node); e < engine->getLinkEnd(node); e++) {
+                if (!isUsable(e))
+                    continue;
+                int neighbor = engine->getLinkTarget(e);
+                double nd = top.first + engine->getLinkWeight(e);
+                if (nd < dist[row + neighbor]) {
+                    dist[row + neighbor] = nd;
+                    parentLink[row + neighbor] = e;
+                    heap.push(HeapEntry(nd, neighbor));
+                }
+            }
+        }
+    }
+}
+
+void DynamicRouting::setLinkState(int from, int to, bool up)
+{
+    for (int e = engine->getLinkBegin(from); e < engine->getLinkEnd(from); e++) {
+        if (engine->getLinkTarget(e) != to || linkUp[e] == up)
+            continue;
+        bool wasUsable = isUsable(e);
+        linkUp[e] = up;
+        if (wasUsable && !up)
+            linkRemoved(e);
+        else if (!wasUsable && isUsable(e))
+            linkAdded(e);
+    }
+}
+
+void DynamicRouting::setNodeState(int node, bool up)
+{
+    if (nodeUp[node] == up)
+        return;
+
+    // collect the links whose usability changes with the node
+    std::vector<int> links;
+    for (int e = engine->getLinkBegin(node); e < engine->getLinkEnd(node); e++)
+        links.push_back(e);
+    for (int pos = engine->getInLinkBegin(node); pos < engine->getInLinkEnd(node); pos++)
+        links.push_back(engine->getInLink(pos));
+
+    if (!up) {
+        std::vector<int> removed;
+        for (int e : links)
+            if (isUsable(e))
+                removed.push_back(e);
+        nodeUp[node] = 0;
+        for (int e : removed)
+            linkRemoved(e);
+
+        // the node's own tree is gone
+        size_t row = (size_t)node * numNodes;
+        for (int i = 0; i < numNodes; i++) {
+            dist[row + i] = INF;
+            parentLink[row + i] = -1;
+            settle(node, i);
+        }
+    }
+    else {
+        nodeUp[node] = 1;
+        computeTree(node);
+        for (int e : links)
+            linkAdded(e);
+    }
+}
@@ -0,0 +1,89 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#ifndef __DYNAMICROUTING_H
+#define __DYNAMICROUTING_H
+
+#include <cstdint>
+#include <vector>
+#include "RoutingEngine.h"
+
+/**
+ * Incrementally maintained shortest path trees of all routers, for runs
+ * with link and node failures.
+ *
+ * Every source node keeps its tree (distance and parent link of every node)
+ * and its next-hop row. When a link goes down, only the trees that use it
+ * are touched, and in those only the subtree hanging off the link is
+ * recomputed, from the intact rest of the tree. When a link comes up, only
+ * the nodes whose distance improves are updated. Changed next hops are
+ * reported to the listener registered for the source, which patches its
+ * forwarding table in place.
+ *
+ * There is a single instance per simulation run, shared the same way as
+ * RoutingDatabase. The routing engine must outlive it.
+ */
+class DynamicRouting
+{
+  public:
+    class IListener {
+      public:
+        virtual ~IListener() {}
+        virtual void nextHopChanged(int destAddress, int gateIndex) = 0;
+    };
+
+  private:
+    const RoutingEngine *engine;
+    int numNodes;
+    std::vector<double> dist;        // [source * numNodes + node]
+    std::vector<int> parentLink;     // [source * numNodes + node], -1 if none
+    std::vector<int16_t> nextHops;   // [source * numNodes + node]
+    std::vector<int> linkSource;     // link -> sending node
+    std::vector<char> linkUp;
+    std::vector<char> nodeUp;
+    std::vector<IListener *> listeners;  // per source node
+
+    // scratch state for repairs
+    std::vector<int> affectedStamp;
+    int stamp = 0;
+
+    // statistics
+    long numTreesRepaired = 0;
+    long numNodesUpdated = 0;
+
+    static DynamicRouting *instance;
+    static int numUsers;
+
+  protected:
+    DynamicRouting(const RoutingEngine *engine);
+
+    bool isUsable(int link) const { return linkUp[link] && nodeUp[linkSource[link]] && nodeUp[engine->getLinkTarget(link)]; }
+    void computeTree(int source);
+    void linkRemoved(int link);
+    void linkAdded(int link);
+    void settle(int source, int node);
+
+  public:
+    static DynamicRouting *acquire(const RoutingEngine *engine);
+    static void release();
+
+    const int16_t *getRow(int source) const { return nextHops.data() + (size_t)source * numNodes; }
+    void setListener(int source, IListener *listener) { listeners[source] = listener; }
+
+    /** Changes the state of all links from one node to another (node indices) */
+    void setLinkState(int from, int to, bool up);
+
+    /** Changes the state of a node; links of a down node are unusable */
+    void setNodeState(int node, bool up);
+
+    long getNumTreesRepaired() const { return numTreesRepaired; }
+    long getNumNodesUpdated() const { return numNodesUpdated; }
+};
+
+#endif
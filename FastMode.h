@@ -0,0 +1,28 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#ifndef __FAST_MODE_H
+#define __FAST_MODE_H
+
+//
+// Logging in per-packet code paths. HOT_EV is used like EV, but the
+// statement is skipped when the module's fastMode member is true, so the
+// stream arguments (packet names etc.) are not even evaluated. Building
+// with -DFAST_MODE removes these statements at compile time and forces
+// fastMode on, which also turns off bubbles and display string updates.
+//
+#ifdef FAST_MODE
+#define FAST_MODE_FORCED  true
+#define HOT_EV            if (true) ; else EV
+#else
+#define FAST_MODE_FORCED  false
+#define HOT_EV            if (fastMode) ; else EV
+#endif
+
+#endif
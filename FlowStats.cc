@@ -0,0 +1,67 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#include <algorithm>
+#include <cmath>
+#include "FlowStats.h"
+
+constexpr double FlowStats::HISTOGRAM_MIN;
+constexpr double FlowStats::HISTOGRAM_MAX;
+
+int FlowStats::getBin(double value)
+{
+    if (!(value > HISTOGRAM_MIN))
+        return 0;
+    int bin = (int)(std::log(value / HISTOGRAM_MIN) / std::log(HISTOGRAM_MAX / HISTOGRAM_MIN) * NUM_BINS);
+    return std::min(bin, NUM_BINS - 1);
+}
+
+double FlowStats::getBinLowerBound(int bin)
+{
+    return HISTOGRAM_MIN * std::pow(HISTOGRAM_MAX / HISTOGRAM_MIN, (double)bin / NUM_BINS);
+}
+
+void FlowStats::collect(double value)
+{
+    if (count == 0)
+        min = max = value;
+    else {
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+    count++;
+    double delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+    bins[getBin(value)]++;
+}
+
+double FlowStats::getStddev() const
+{
+    return std::sqrt(getVariance());
+}
+
+double FlowStats::getQuantile(double q) const
+{
+    if (count == 0)
+        return 0;
+    double rank = q * count;
+    uint64_t cumulated = 0;
+    for (int bin = 0; bin < NUM_BINS; bin++) {
+        if (bins[bin] == 0 || cumulated + bins[bin] < rank) {
+            cumulated += bins[bin];
+            continue;
+        }
+        double fraction = (rank - cumulated) / bins[bin];
+        double lower = getBinLowerBound(bin), upper = getBinLowerBound(bin + 1);
+        double value = lower * std::pow(upper / lower, fraction);
+        return std::max(min, std::min(max, value));
+    }
+    return max;
+}
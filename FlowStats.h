@@ -0,0 +1,61 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#ifndef __FLOW_STATS_H
+#define __FLOW_STATS_H
+
+#include <cstdint>
+
+/**
+ * Streaming summary of one quantity: count, mean and variance (Welford's
+ * method), min/max, and a fixed-bin histogram with logarithmically spaced
+ * bins for approximate quantiles. The object has a fixed size and does not
+ * allocate, so one can be kept per flow. Does not depend on the simulation
+ * kernel.
+ */
+class FlowStats
+{
+  public:
+    enum { NUM_BINS = 64 };
+
+    // histogram range; values outside it go to the first or last bin
+    static constexpr double HISTOGRAM_MIN = 1e-6;
+    static constexpr double HISTOGRAM_MAX = 1e3;
+
+  private:
+    uint64_t count = 0;
+    double mean = 0;
+    double m2 = 0;  // sum of squared differences from the mean
+    double min = 0;
+    double max = 0;
+    uint32_t bins[NUM_BINS] = {};
+
+  protected:
+    static int getBin(double value);
+    static double getBinLowerBound(int bin);
+
+  public:
+    void collect(double value);
+
+    uint64_t getCount() const { return count; }
+    double getMean() const { return mean; }
+    double getVariance() const { return count > 1 ? m2 / (count - 1) : 0; }
+    double getStddev() const;
+    double getMin() const { return min; }
+    double getMax() const { return max; }
+
+    /**
+     * Returns the approximate q-quantile (0 <= q <= 1), interpolated
+     * geometrically within the histogram bin and clamped to [min, max].
+     * The relative error is bounded by the bin width (about 40%).
+     */
+    double getQuantile(double q) const;
+};
+
+#endif
@@ -0,0 +1,107 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#include <stdexcept>
+#include <string>
+#include "NextHopTable.h"
+
+int NextHopTable::addGroup(const int16_t *groupGates, int count, bool keepOrder)
+{
+    if (count == 0)
+        return UNREACHABLE;
+    if (count == 1)
+        return groupGates[0];
+
+    Group group;
+    group.count = std::min(count, MAX_GROUP_SIZE);
+    if (keepOrder || count <= MAX_GROUP_SIZE) {
+        std::copy(groupGates, groupGates + group.count, group.gates);
+        if (!keepOrder) {
+            // insertion sort of at most MAX_GROUP_SIZE gates
+            for (int i = 1; i < group.count; i++)
+                for (int j = i; j > 0 && group.gates[j] < group.gates[j - 1]; j--)
+                    std::swap(group.gates[j], group.gates[j - 1]);
+        }
+    }
+    else {
+        // truncated to the lowest gate indices, whatever the input order
+        std::vector<int16_t> sorted(groupGates, groupGates + count);
+        std::partial_sort(sorted.begin(), sorted.begin() + group.count, sorted.end());
+        std::copy(sorted.begin(), sorted.begin() + group.count, group.gates);
+    }
+
+    // unordered sets of a router are few, but with keepOrder every ordered
+    // prefix of up to MAX_GROUP_SIZE gates is a group of its own (O(ports^4)
+    // on large switches), so groups are looked up by their gate tuple packed
+    // into 15 bits per gate (gate indices are non-negative int16_t values)
+    uint64_t key = group.count;
+    for (int i = 0; i < group.count; i++)
+        key = (key << 15) | (uint16_t)group.gates[i];
+    auto it = groupIndex.find(key);
+    if (it != groupIndex.end())
+        return FIRST_GROUP - it->second;
+
+    int index = groups.size();
+    if (FIRST_GROUP - index < INT16_MIN)
+        throw std::length_error("Too many distinct multipath groups (" + std::to_string(index + 1) + ") for the next-hop table");
+    groups.push_back(group);
+    groupIndex[key] = index;
+    return FIRST_GROUP - index;
+}
+
+void NextHopTable::build(std::vector<std::pair<int, int>> entries, Type type)
+{
+    std::sort(entries.begin(), entries.end());
+    numEntries = entries.size();
+    gates.clear();
+    addresses.clear();
+    baseAddress = 0;
+
+    if (entries.empty()) {
+        dense = true;
+        return;
+    }
+
+    int minAddress = entries.front().first;
+    long span = (long)entries.back().first - minAddress + 1;
+    if (type == AUTO)
+        type = span <= 4L * numEntries + 64 ? DENSE : SPARSE;
+
+    dense = (type == DENSE);
+    if (dense) {
+        baseAddress = minAddress;
+        gates.assign(span, UNREACHABLE);
+        for (const auto& entry : entries)
+            gates[entry.first - baseAddress] = entry.second;
+    }
+    else {
+        addresses.reserve(numEntries);
+        gates.reserve(numEntries);
+        for (const auto& entry : entries) {
+            addresses.push_back(entry.first);
+            gates.push_back(entry.second);
+        }
+    }
+}
+
+bool NextHopTable::set(int address, int gateIndex)
+{
+    if (dense) {
+        unsigned int i = (unsigned int)(address - baseAddress);
+        if (i >= gates.size())
+            return false;
+        gates[i] = gateIndex;
+        return true;
+    }
+    auto it = std::lower_bound(addresses.begin(), addresses.end(), address);
+    if (it == addresses.end() || *it != address)
+        return false;
+    gates[it - addresses.begin()] = gateIndex;
+    return true;
+}
@@ -0,0 +1,128 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#ifndef __NEXTHOPTABLE_H
+#define __NEXTHOPTABLE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Flat destination address -> output gate index table for the forwarding
+ * path. Dense address ranges are stored as a contiguous array indexed by
+ * address (one int16_t per address); sparse address sets fall back to a
+ * sorted array searched with binary search.
+ *
+ * For multipath (ECMP) routing, an entry may refer to a group of gates
+ * instead of a single gate. Groups are stored once per distinct gate set,
+ * in a small inline array, and selected from by a per-flow hash.
+ */
+class NextHopTable
+{
+  public:
+    static constexpr int UNREACHABLE = -1;
+    static constexpr int UNKNOWN = -2;  // not computed yet (lazy routing)
+    enum Type { AUTO, DENSE, SPARSE };
+    static constexpr int MAX_GROUP_SIZE = 4;
+
+  private:
+    static constexpr int FIRST_GROUP = -3;  // entries <= FIRST_GROUP refer to groups[FIRST_GROUP-entry]
+
+    struct Group {
+        uint8_t count;
+        int16_t gates[MAX_GROUP_SIZE];
+    };
+    std::vector<Group> groups;
+    std::unordered_map<uint64_t, int> groupIndex;  // packed gate tuple -> index into groups
+
+    bool dense = true;
+    int baseAddress = 0;
+    std::vector<int16_t> gates;   // dense: indexed by address-baseAddress; sparse: parallel to addresses
+    std::vector<int> addresses;   // sparse mode only, sorted
+    int numEntries = 0;
+
+  public:
+    /**
+     * Fills the table from (address, gate index) pairs. With AUTO, the dense
+     * layout is chosen unless the address range is much larger than the
+     * number of entries. Entry values may be gate indices, UNKNOWN, or group
+     * references returned by addGroup(); groups are kept across build() calls.
+     */
+    void build(std::vector<std::pair<int, int>> entries, Type type = AUTO);
+
+    int lookup(int address) const {
+        if (dense) {
+            unsigned int i = (unsigned int)(address - baseAddress);
+            return i < gates.size() ? gates[i] : UNREACHABLE;
+        }
+        auto it = std::lower_bound(addresses.begin(), addresses.end(), address);
+        return (it != addresses.end() && *it == address) ? gates[it - addresses.begin()] : UNREACHABLE;
+    }
+
+    /**
+     * Updates the gate index for an address that was present in build().
+     * Returns false if the address is not in the table.
+     */
+    bool set(int address, int gateIndex);
+
+    /**
+     * Returns the entry value that refers to the given set of gates, to be
+     * passed to build() or set(). A single gate is returned as is; larger
+     * sets are shared between entries. With keepOrder, the gates are stored
+     * in the given order (preferred gate first), otherwise sorted. Sets of
+     * more than MAX_GROUP_SIZE gates are truncated: to the first gates with
+     * keepOrder, to the lowest gate indices otherwise. Throws std::length_error
+     * when there are more distinct groups than the int16_t entries can refer
+     * to (the table does not depend on the simulation kernel).
+     */
+    int addGroup(const int16_t *groupGates, int count, bool keepOrder = false);
+
+    /**
+     * Multipath lookup: like lookup(), but if the entry is a group, one of
+     * its gates is selected by the flow hash.
+     */
+    int lookup(int address, uint32_t flowHash) const {
+        int entry = lookup(address);
+        if (entry > FIRST_GROUP)
+            return entry;
+        const Group& group = groups[FIRST_GROUP - entry];
+        return group.gates[flowHash % group.count];
+    }
+
+    /**
+     * Load-aware lookup: like lookup(), but if the entry is a group, the gate
+     * with the smallest gateLoads[gate] value is selected. Ties go to the
+     * gate stored first.
+     */
+    int lookupLeastLoaded(int address, const double *gateLoads) const {
+        int entry = lookup(address);
+        if (entry > FIRST_GROUP)
+            return entry;
+        const Group& group = groups[FIRST_GROUP - entry];
+        int best = group.gates[0];
+        for (int i = 1; i < group.count; i++)
+            if (gateLoads[group.gates[i]] < gateLoads[best])
+                best = group.gates[i];
+        return best;
+    }
+
+    bool isDense() const { return dense; }
+    int getNumEntries() const { return numEntries; }
+    int getNumGroups() const { return groups.size(); }
+    size_t getMemoryUsage() const {
+        return gates.capacity() * sizeof(int16_t) + addresses.capacity() * sizeof(int) + groups.capacity() * sizeof(Group) +
+               groupIndex.bucket_count() * sizeof(void *) + groupIndex.size() * (sizeof(std::pair<const uint64_t, int>) + sizeof(void *));
+    }
+};
+
+#endif
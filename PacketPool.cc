@@ -0,0 +1,60 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#include <algorithm>
+#include "PacketPool.h"
+
+std::vector<Packet *> PacketPool::freePackets;
+size_t PacketPool::capacity = 0;
+int PacketPool::numUsers = 0;
+
+void PacketPool::acquire(size_t requestedCapacity)
+{
+    numUsers++;
+    capacity = std::max(capacity, requestedCapacity);
+}
+
+void PacketPool::release()
+{
+    if (numUsers == 0 || --numUsers > 0)
+        return;
+    for (Packet *pk : freePackets)
+        delete pk;
+    freePackets.clear();
+    freePackets.shrink_to_fit();
+    capacity = 0;
+}
+
+Packet *PacketPool::get()
+{
+    if (freePackets.empty())
+        return nullptr;
+    Packet *pk = freePackets.back();
+    freePackets.pop_back();
+    pk->setKind(0);
+    pk->setBitLength(0);
+    pk->setBitError(false);
+    pk->setSrcAddr(0);
+    pk->setDestAddr(0);
+    pk->setHopCount(0);
+    pk->setTimestamp(SIMTIME_ZERO);
+    return pk;
+}
+
+bool PacketPool::put(Packet *pk)
+{
+    if (freePackets.size() >= capacity)
+        return false;
+    // nothing attached by the previous user may reach the next one
+    delete pk->removeControlInfo();
+    pk->getParList().clear();
+    pk->setContextPointer(nullptr);
+    freePackets.push_back(pk);
+    return true;
+}
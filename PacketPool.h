@@ -0,0 +1,63 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#ifndef __PACKET_POOL_H
+#define __PACKET_POOL_H
+
+#include <cstddef>
+#include <vector>
+#include "Packet_m.h"
+
+/**
+ * Free list of Packet objects, shared by all BurstyApp modules: sinks put
+ * the packets they have consumed back into the pool, and sources reuse them
+ * instead of allocating new ones. Pooled packets have no owner; the caller
+ * must drop() a packet before put() and take() it after get().
+ *
+ * Control info, par() objects and the context pointer are removed when a
+ * packet is put back. A recycled packet keeps its message ID, though, and
+ * its creation time is that of the original allocation: users should rely
+ * on the timestamp instead, and must not pool packets where message IDs
+ * have to be unique, i.e. when an eventlog is recorded or a GUI shows the
+ * packets (see BurstyApp).
+ */
+class PacketPool
+{
+  private:
+    static std::vector<Packet *> freePackets;
+    static size_t capacity;
+    static int numUsers;
+
+  public:
+    /**
+     * Registers a user of the pool. The pool holds at most the largest
+     * capacity requested by any user; 0 disables pooling for this user.
+     * Every call must be paired with release(); the last release() deletes
+     * the pooled packets.
+     */
+    static void acquire(size_t capacity);
+    static void release();
+
+    /**
+     * Returns a recycled packet with its kind, length, bit error flag,
+     * timestamp and fields reset, or nullptr if the pool is empty.
+     */
+    static Packet *get();
+
+    /**
+     * Stores the packet for reuse, after deleting its control info and par()
+     * list. Returns false if the pool is full; the packet must then be
+     * deleted by the caller.
+     */
+    static bool put(Packet *pk);
+
+    static size_t getSize() { return freePackets.size(); }
+};
+
+#endif
@@ -0,0 +1,223 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#include <algorithm>
+#include <cstring>
+#include "PacketTrace.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char MAGIC[8] = { 'P', 'K', 'T', 'R', 'A', 'C', 'E', '1' };
+
+struct Header {
+    char magic[8];
+    uint32_t recordSize;
+    uint32_t reserved;
+    uint64_t numRecords;
+};
+
+const uint64_t RELEASE_BATCH = 65536;  // records consumed between releasing their pages
+const size_t READ_AHEAD = 256;         // records per read where mmap is not available
+
+}  // namespace
+
+PacketTrace *PacketTrace::instance = nullptr;
+int PacketTrace::numUsers = 0;
+
+PacketTrace::~PacketTrace()
+{
+#ifndef _WIN32
+    if (mapping)
+        munmap(mapping, mappingSize);
+#endif
+    if (file)
+        fclose(file);
+}
+
+PacketTrace *PacketTrace::acquire(const char *fileName, std::string& error)
+{
+    if (instance && instance->fileName != fileName) {
+        error = "conflicting trace files '" + instance->fileName + "' and '" + fileName + "'";
+        return nullptr;
+    }
+    if (!instance) {
+        PacketTrace *trace = new PacketTrace();
+        if (!trace->open(fileName, error)) {
+            delete trace;
+            return nullptr;
+        }
+        instance = trace;
+    }
+    numUsers++;
+    return instance;
+}
+
+void PacketTrace::release()
+{
+    if (--numUsers == 0) {
+        delete instance;
+        instance = nullptr;
+    }
+}
+
+bool PacketTrace::open(const char *name, std::string& error)
+{
+    fileName = name;
+    Header header;
+    uint64_t size = 0;
+
+#ifndef _WIN32
+    int fd = ::open(name, O_RDONLY);
+    if (fd == -1) {
+        error = "cannot open '" + fileName + "'";
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0)
+        size = info.st_size;
+    if (size >= sizeof(Header)) {
+        void *p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) {
+            mapping = p;
+            mappingSize = size;
+        }
+    }
+    ::close(fd);
+    if (!mapping) {
+        error = "cannot map '" + fileName + "'";
+        return false;
+    }
+    memcpy(&header, mapping, sizeof(header));
+#else
+    file = fopen(name, "rb");
+    if (!file) {
+        error = "cannot open '" + fileName + "'";
+        return false;
+    }
+    _fseeki64(file, 0, SEEK_END);
+    size = _ftelli64(file);
+    _fseeki64(file, 0, SEEK_SET);
+    if (size < sizeof(Header) || fread(&header, sizeof(header), 1, file) != 1) {
+        error = "'" + fileName + "' is not a packet trace";
+        return false;
+    }
+#endif
+
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.recordSize != sizeof(Record)) {
+        error = "'" + fileName + "' is not a packet trace";
+        return false;
+    }
+    if (size != sizeof(Header) + header.numRecords * sizeof(Record)) {
+        error = "'" + fileName + "' is truncated";
+        return false;
+    }
+    numRecords = header.numRecords;
+    if (mapping)
+        records = (const Record *)((const char *)mapping + sizeof(Header));
+
+    // one binary search per source for the end of its range; this only
+    // touches O(numSources * log(numRecords)) records
+    for (uint64_t pos = 0; pos < numRecords; ) {
+        int32_t src = readRecord(pos).src;
+        if (!sources.empty() && src <= sources.back().src) {
+            error = "'" + fileName + "' is not sorted by source address";
+            return false;
+        }
+        uint64_t lo = pos + 1, hi = numRecords;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if (readRecord(mid).src <= src)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        sources.push_back(SourceRange { src, pos, lo });
+        pos = lo;
+    }
+    releaseRecords(0, numRecords);
+    return true;
+}
+
+PacketTrace::Record PacketTrace::readRecord(uint64_t index) const
+{
+    Record record;
+    readRecords(index, 1, &record);
+    return record;
+}
+
+void PacketTrace::readRecords(uint64_t first, size_t count, Record *out) const
+{
+    if (records) {
+        std::copy(records + first, records + first + count, out);
+        return;
+    }
+#ifdef _WIN32
+    _fseeki64(file, sizeof(Header) + first * sizeof(Record), SEEK_SET);  // traces may exceed 2GB
+#else
+    fseek(file, (long)(sizeof(Header) + first * sizeof(Record)), SEEK_SET);
+#endif
+    if (fread(out, sizeof(Record), count, file) != count)
+        memset(out, 0, count * sizeof(Record));  // the size was checked at open, so only on I/O errors
+}
+
+void PacketTrace::releaseRecords(uint64_t first, uint64_t end) const
+{
+#ifndef _WIN32
+    // only whole pages inside the range; the mapping is read-only, so the
+    // pages are simply read again from the file if they are needed later
+    if (!mapping)
+        return;
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t from = sizeof(Header) + first * sizeof(Record);
+    size_t to = sizeof(Header) + end * sizeof(Record);
+    from = (from + pageSize - 1) / pageSize * pageSize;
+    to = to / pageSize * pageSize;
+    if (from < to)
+        madvise((char *)mapping + from, to - from, MADV_DONTNEED);
+#endif
+}
+
+PacketTrace::Cursor PacketTrace::getCursor(int src) const
+{
+    Cursor cursor;
+    cursor.trace = this;
+    auto it = std::lower_bound(sources.begin(), sources.end(), src,
+                               [](const SourceRange& range, int value) { return range.src < value; });
+    if (it != sources.end() && it->src == src) {
+        cursor.pos = cursor.releasedUpTo = it->begin;
+        cursor.end = it->end;
+    }
+    return cursor;
+}
+
+const PacketTrace::Record& PacketTrace::Cursor::next()
+{
+    if (trace->records) {
+        const Record& record = trace->records[pos++];
+        if (pos - releasedUpTo > RELEASE_BATCH) {
+            trace->releaseRecords(releasedUpTo, pos - 1);  // keep the returned record
+            releasedUpTo = pos - 1;
+        }
+        return record;
+    }
+    if (bufferPos == buffer.size()) {
+        buffer.resize(std::min<uint64_t>(READ_AHEAD, end - pos));
+        trace->readRecords(pos, buffer.size(), buffer.data());
+        bufferPos = 0;
+    }
+    pos++;
+    return buffer[bufferPos++];
+}
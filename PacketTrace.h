@@ -0,0 +1,109 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#ifndef __PACKET_TRACE_H
+#define __PACKET_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * Packet trace for replay, memory-mapped so that only the pages being
+ * replayed are resident; traces larger than the RAM work. Records are
+ * sorted by source address and, within a source, by time (tools/mktrace.py
+ * writes such files), so the records of one source are a contiguous range.
+ * The per-source ranges are found once, with a binary search per source,
+ * without reading the whole file.
+ *
+ * Layout (native byte order):
+ *   char magic[8] = "PKTRACE1", uint32 recordSize (= 24), uint32 reserved,
+ *   uint64 numRecords, Record records[numRecords]
+ *
+ * There is one shared instance per run; modules acquire it in initialize()
+ * and release it when they are deleted.
+ */
+class PacketTrace
+{
+  public:
+    struct Record {
+        double time;      // seconds
+        int32_t src;
+        int32_t dest;
+        uint32_t length;  // bytes
+        uint32_t reserved;
+    };
+
+    /**
+     * Sequential reader of the records of one source. Consumed pages are
+     * dropped from memory as the cursor moves on.
+     */
+    class Cursor
+    {
+        friend class PacketTrace;
+      private:
+        const PacketTrace *trace = nullptr;
+        uint64_t pos = 0, end = 0;
+        uint64_t releasedUpTo = 0;  // records before this were given back to the OS
+        std::vector<Record> buffer; // records read ahead where mmap is not available
+        size_t bufferPos = 0;
+
+      public:
+        bool hasNext() const { return pos < end; }
+        uint64_t getRemaining() const { return end - pos; }
+
+        /** Returns the next record; only valid if hasNext() is true. */
+        const Record& next();
+    };
+
+  private:
+    struct SourceRange {
+        int32_t src;
+        uint64_t begin, end;
+    };
+
+    std::string fileName;
+    uint64_t numRecords = 0;
+    const Record *records = nullptr;  // mapped records, or nullptr
+    void *mapping = nullptr;
+    size_t mappingSize = 0;
+    FILE *file = nullptr;             // where mmap is not available
+    std::vector<SourceRange> sources; // sorted by src
+
+    static PacketTrace *instance;
+    static int numUsers;
+
+  protected:
+    PacketTrace() {}
+    ~PacketTrace();
+    bool open(const char *fileName, std::string& error);
+    Record readRecord(uint64_t index) const;
+    void readRecords(uint64_t first, size_t count, Record *out) const;
+    void releaseRecords(uint64_t first, uint64_t end) const;
+
+  public:
+    /**
+     * Returns the shared trace, opening the file when called for the first
+     * time. Returns nullptr with the reason in error if the file cannot be
+     * opened, is not a valid trace, or differs from the already open one.
+     * Every successful call must be paired with release().
+     */
+    static PacketTrace *acquire(const char *fileName, std::string& error);
+    static void release();
+
+    uint64_t getNumRecords() const { return numRecords; }
+    int getNumSources() const { return sources.size(); }
+
+    /** Returns a cursor over the records of the given source (possibly none). */
+    Cursor getCursor(int src) const;
+};
+
+#endif
@@ -0,0 +1,59 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#include <algorithm>
+#include "RateMeter.h"
+
+void RateMeter::configure(double intervalLength, int numBuckets)
+{
+    interval = intervalLength;
+    bucketBytes.assign(std::max(numBuckets, 2), 0);
+    bucketPackets.assign(bucketBytes.size(), 0);
+    currentInterval = 0;
+    totalBytes = totalPackets = peakBytes = peakPackets = 0;
+}
+
+void RateMeter::advance(double t)
+{
+    int64_t target = (int64_t)(t / interval);
+    if (target <= currentInterval)
+        return;
+    // close the current interval, then clear the buckets of the skipped
+    // (empty) ones; after a full ring, the remaining ones are all zero
+    size_t size = bucketBytes.size();
+    size_t bucket = currentInterval % size;
+    peakBytes = std::max(peakBytes, bucketBytes[bucket]);
+    peakPackets = std::max(peakPackets, bucketPackets[bucket]);
+    int64_t numCleared = std::min<int64_t>(target - currentInterval, size);
+    for (int64_t i = 1; i <= numCleared; i++) {
+        bucket = (currentInterval + i) % size;
+        bucketBytes[bucket] = 0;
+        bucketPackets[bucket] = 0;
+    }
+    currentInterval = target;
+}
+
+double RateMeter::getLastIntervalRate() const
+{
+    if (currentInterval == 0)
+        return 0;
+    return bucketBytes[(currentInterval - 1) % bucketBytes.size()] / interval;
+}
+
+double RateMeter::getWindowRate() const
+{
+    // the ring holds the current interval plus size-1 closed ones
+    int64_t numClosed = std::min<int64_t>(currentInterval, bucketBytes.size() - 1);
+    if (numClosed == 0)
+        return 0;
+    uint64_t sum = 0;
+    for (int64_t i = 1; i <= numClosed; i++)
+        sum += bucketBytes[(currentInterval - i) % bucketBytes.size()];
+    return sum / (numClosed * interval);
+}
@@ -0,0 +1,70 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#ifndef __RATE_METER_H
+#define __RATE_METER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Windowed throughput meter: packet and byte counts per fixed time
+ * interval, kept in a ring buffer of the last numBuckets intervals, plus
+ * running totals and the peak interval. Recording is a few increments;
+ * intervals are closed lazily when a later time is seen, so the meter
+ * needs no timer. Does not depend on the simulation kernel.
+ */
+class RateMeter
+{
+  private:
+    double interval = 1;
+    std::vector<uint64_t> bucketBytes;    // ring, indexed by interval number % size
+    std::vector<uint64_t> bucketPackets;
+    int64_t currentInterval = 0;          // interval that receives new records
+    uint64_t totalBytes = 0;
+    uint64_t totalPackets = 0;
+    uint64_t peakBytes = 0;               // of a closed interval
+    uint64_t peakPackets = 0;
+
+  public:
+    /** Sets the interval length (seconds) and the number of intervals in the window. */
+    void configure(double interval, int numBuckets);
+
+    /** Closes the intervals that end at or before time t. */
+    void advance(double t);
+
+    /** Counts a packet at time t; times must not decrease. */
+    void record(double t, int64_t bytes) {
+        if (t >= (currentInterval + 1) * interval)
+            advance(t);
+        size_t bucket = currentInterval % bucketBytes.size();
+        bucketBytes[bucket] += bytes;
+        bucketPackets[bucket]++;
+        totalBytes += bytes;
+        totalPackets++;
+    }
+
+    double getInterval() const { return interval; }
+    int64_t getCurrentInterval() const { return currentInterval; }
+    uint64_t getTotalBytes() const { return totalBytes; }
+    uint64_t getTotalPackets() const { return totalPackets; }
+
+    /** Bytes/s in the last closed interval. */
+    double getLastIntervalRate() const;
+
+    /** Mean bytes/s over the closed intervals in the window (up to numBuckets-1). */
+    double getWindowRate() const;
+
+    /** Highest bytes/s and packets/s of any closed interval. */
+    double getPeakRate() const { return peakBytes / interval; }
+    double getPeakPacketRate() const { return peakPackets / interval; }
+};
+
+#endif
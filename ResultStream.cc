@@ -0,0 +1,117 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#include <cstring>
+#include <omnetpp.h>
+#include "ResultStream.h"
+
+using namespace omnetpp;
+
+static const char MAGIC[8] = { 'R', 'O', 'U', 'T', 'C', 'O', 'L', '1' };
+static const uint32_t CHUNK_TAG = 0x4b4e4843;  // "CHNK"
+static const uint32_t DICT_TAG = 0x54434944;   // "DICT"
+
+ResultStream *ResultStream::instance = nullptr;
+int ResultStream::numUsers = 0;
+
+ResultStream *ResultStream::acquire(const char *fileName)
+{
+    // every partition of a parallel run writes its own file
+    std::string partitionFileName;
+    if (getEnvir()->getParsimNumPartitions() > 1) {
+        partitionFileName = std::string(fileName) + "." + std::to_string(getEnvir()->getParsimProcId());
+        fileName = partitionFileName.c_str();
+    }
+    if (!instance)
+        instance = new ResultStream(fileName);
+    else if (instance->fileName != fileName)
+        throw cRuntimeError("ResultStream: conflicting file names '%s' and '%s'", instance->fileName.c_str(), fileName);
+    numUsers++;
+    return instance;
+}
+
+void ResultStream::release()
+{
+    if (numUsers > 0 && --numUsers == 0) {
+        delete instance;
+        instance = nullptr;
+    }
+}
+
+ResultStream::ResultStream(const char *fileName) : fileName(fileName)
+{
+    file = fopen(fileName, "wb");
+    if (!file)
+        throw cRuntimeError("ResultStream: cannot open '%s' for writing", fileName);
+    fwrite(MAGIC, 1, sizeof(MAGIC), file);
+    times.reserve(CHUNK_ROWS);
+    sourceIds.reserve(CHUNK_ROWS);
+    metricIdColumn.reserve(CHUNK_ROWS);
+    values.reserve(CHUNK_ROWS);
+}
+
+ResultStream::~ResultStream()
+{
+    flushChunk();
+    writeFooter();
+    fclose(file);
+}
+
+int ResultStream::addSource(const char *name)
+{
+    sources.push_back(name);
+    return sources.size() - 1;
+}
+
+int ResultStream::getMetricId(const char *name)
+{
+    auto it = metricIds.find(name);
+    if (it != metricIds.end())
+        return it->second;
+    metrics.push_back(name);
+    return metricIds[name] = metrics.size() - 1;
+}
+
+void ResultStream::flushChunk()
+{
+    if (times.empty())
+        return;
+    // the header and the two int32 columns keep the double columns aligned
+    uint32_t header[2] = { CHUNK_TAG, (uint32_t)times.size() };
+    fwrite(header, sizeof(header), 1, file);
+    fwrite(times.data(), sizeof(double), times.size(), file);
+    fwrite(sourceIds.data(), sizeof(int32_t), sourceIds.size(), file);
+    fwrite(metricIdColumn.data(), sizeof(int32_t), metricIdColumn.size(), file);
+    fwrite(values.data(), sizeof(double), values.size(), file);
+    times.clear();
+    sourceIds.clear();
+    metricIdColumn.clear();
+    values.clear();
+}
+
+void ResultStream::writeStrings(const std::vector<std::string>& strings)
+{
+    uint32_t count = strings.size();
+    fwrite(&count, sizeof(count), 1, file);
+    for (const std::string& s : strings) {
+        uint32_t length = s.size();
+        fwrite(&length, sizeof(length), 1, file);
+        fwrite(s.data(), 1, length, file);
+    }
+}
+
+void ResultStream::writeFooter()
+{
+    uint64_t footerOffset = ftell(file);
+    fwrite(&DICT_TAG, sizeof(DICT_TAG), 1, file);
+    writeStrings(sources);
+    writeStrings(metrics);
+    fwrite(&footerOffset, sizeof(footerOffset), 1, file);
+    fwrite(MAGIC, 1, sizeof(MAGIC), file);
+}
@@ -0,0 +1,93 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#ifndef __RESULT_STREAM_H
+#define __RESULT_STREAM_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Columnar binary result file, written while the simulation runs, one file
+ * per run. Every row is (time, source, metric, value); sources (module
+ * paths) and metrics (names) are interned to small integer ids. Rows are
+ * buffered column by column and written in chunks, so a reader can map the
+ * file and use each chunk's columns in place (see tools/rcol.py).
+ *
+ * File layout (little endian, all arrays 8-byte aligned):
+ *
+ *   "ROUTCOL1"
+ *   chunk*:  uint32 "CHNK", uint32 numRows,
+ *            double time[numRows], int32 source[numRows],
+ *            int32 metric[numRows], double value[numRows]
+ *   footer:  uint32 "DICT", uint32 numSources, {uint32 len, char[len]}*,
+ *            uint32 numMetrics, {uint32 len, char[len]}*
+ *   uint64 footer offset, "ROUTCOL1"
+ *
+ * There is one shared instance per run; modules acquire it in initialize()
+ * and the last release() writes the footer and closes the file. Under
+ * parallel simulation, each partition appends ".<procId>" to the name.
+ */
+class ResultStream
+{
+  public:
+    enum { CHUNK_ROWS = 65536 };
+
+  private:
+    std::string fileName;
+    FILE *file = nullptr;
+    std::vector<std::string> sources;
+    std::vector<std::string> metrics;
+    std::unordered_map<std::string, int> metricIds;
+
+    // current chunk, one array per column
+    std::vector<double> times;
+    std::vector<int32_t> sourceIds;
+    std::vector<int32_t> metricIdColumn;
+    std::vector<double> values;
+
+    static ResultStream *instance;
+    static int numUsers;
+
+  protected:
+    explicit ResultStream(const char *fileName);
+    ~ResultStream();
+    void flushChunk();
+    void writeFooter();
+    void writeStrings(const std::vector<std::string>& strings);
+
+  public:
+    /**
+     * Returns the stream of the current run, opening the file on the first
+     * call. All users must pass the same file name. Every call must be
+     * paired with release().
+     */
+    static ResultStream *acquire(const char *fileName);
+    static void release();
+
+    /** Registers a source (typically a module path) and returns its id. */
+    int addSource(const char *name);
+
+    /** Returns the id of the given metric, registering it if needed. */
+    int getMetricId(const char *name);
+
+    void record(double time, int sourceId, int metricId, double value) {
+        times.push_back(time);
+        sourceIds.push_back(sourceId);
+        metricIdColumn.push_back(metricId);
+        values.push_back(value);
+        if (times.size() >= CHUNK_ROWS)
+            flushChunk();
+    }
+};
+
+#endif
@@ -0,0 +1,65 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#include "RoutePayload.h"
+
+std::shared_ptr<const RoutePayload> RoutePayload::encode(const std::vector<int>& addresses, const int16_t *nextHops)
+{
+    std::shared_ptr<RoutePayload> payload = std::make_shared<RoutePayload>();
+    size_t numNodes = addresses.size();
+    payload->addresses.assign(addresses.begin(), addresses.end());
+    payload->rowOffsets.reserve(numNodes + 1);
+    payload->data.reserve(numNodes * numNodes);
+
+    for (size_t source = 0; source < numNodes; source++) {
+        payload->rowOffsets.push_back(payload->data.size());
+        const int16_t *row = nextHops + source * numNodes;
+        for (size_t dest = 0; dest < numNodes; dest++) {
+            uint32_t value = (uint32_t)(row[dest] + 1);
+            while (value >= 0x80) {
+                payload->data.push_back((uint8_t)(value | 0x80));
+                value >>= 7;
+            }
+            payload->data.push_back((uint8_t)value);
+        }
+    }
+    payload->rowOffsets.push_back(payload->data.size());
+    payload->data.shrink_to_fit();
+    return payload;
+}
+
+int RoutePayload::findNode(int address) const
+{
+    for (size_t i = 0; i < addresses.size(); i++)
+        if (addresses[i] == address)
+            return i;
+    return -1;
+}
+
+void RoutePayload::decodeRow(int source, std::vector<std::pair<int, int>>& entries) const
+{
+    entries.clear();
+    const uint8_t *p = data.data() + rowOffsets[source];
+    for (size_t dest = 0; dest < addresses.size(); dest++) {
+        uint32_t value = 0;
+        int shift = 0;
+        while (*p & 0x80) {
+            value |= (uint32_t)(*p++ & 0x7f) << shift;
+            shift += 7;
+        }
+        value |= (uint32_t)*p++ << shift;
+        if (value != 0)
+            entries.push_back(std::make_pair(addresses[dest], (int)value - 1));
+    }
+}
+
+size_t RoutePayload::getByteSize() const
+{
+    return addresses.size() * sizeof(int32_t) + rowOffsets.size() * sizeof(uint32_t) + data.size();
+}
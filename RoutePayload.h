@@ -0,0 +1,55 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#ifndef __ROUTEPAYLOAD_H
+#define __ROUTEPAYLOAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * Packed binary encoding of a complete next-hop matrix, carried by
+ * RouteUpdate messages. The payload is immutable and shared by reference
+ * between all copies of a message, so flooding it costs no copying.
+ *
+ * Layout: the node addresses as a fixed-width array, a row offset table,
+ * then one row per source node with each (gate index + 1) as a varint, so
+ * 0 means "no route" and gates below 127 take one byte.
+ */
+class RoutePayload
+{
+  private:
+    std::vector<int32_t> addresses;
+    std::vector<uint32_t> rowOffsets;  // numNodes+1 entries into data
+    std::vector<uint8_t> data;
+
+  public:
+    /** Encodes a numNodes x numNodes matrix of next hop gate indices (-1: none) */
+    static std::shared_ptr<const RoutePayload> encode(const std::vector<int>& addresses, const int16_t *nextHops);
+
+    int getNumNodes() const { return addresses.size(); }
+    int getAddress(int node) const { return addresses[node]; }
+
+    /** Returns the node index of an address, or -1; linear search */
+    int findNode(int address) const;
+
+    /**
+     * Decodes the row of the given source node into (destination address,
+     * gate index) pairs; destinations without a route are omitted.
+     */
+    void decodeRow(int source, std::vector<std::pair<int, int>>& entries) const;
+
+    /** Encoded size in bytes, used as the message length */
+    size_t getByteSize() const;
+};
+
+#endif
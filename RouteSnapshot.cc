@@ -0,0 +1,149 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include "RouteSnapshot.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char MAGIC[8] = { 'R', 'T', 'S', 'N', 'A', 'P', '0', '1' };
+
+struct Header {
+    char magic[8];
+    uint32_t numNodes;
+    uint32_t reserved;
+    uint64_t topologyHash;
+    uint64_t checksum;
+};
+
+}  // namespace
+
+uint64_t RouteSnapshot::checksum(const int16_t *matrix, size_t count)
+{
+    // FNV-1a style mixing over 64-bit words, then the remaining entries
+    const uint64_t prime = 0x100000001b3ULL;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t numWords = count / 4;
+    for (size_t i = 0; i < numWords; i++) {
+        uint64_t word;
+        memcpy(&word, matrix + 4 * i, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for (size_t i = 4 * numWords; i < count; i++)
+        hash = (hash ^ (uint16_t)matrix[i]) * prime;
+    return hash;
+}
+
+void RouteSnapshot::close()
+{
+#ifndef _WIN32
+    if (mapping)
+        munmap(mapping, mappingSize);
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    buffer.clear();
+    matrix = nullptr;
+}
+
+bool RouteSnapshot::open(const char *fileName, uint64_t topologyHash, int expectedNumNodes, std::string& error)
+{
+    close();
+    size_t expectedSize = sizeof(Header) + (size_t)expectedNumNodes * expectedNumNodes * sizeof(int16_t);
+    const char *data = nullptr;
+    size_t size = 0;
+
+#ifndef _WIN32
+    int fd = ::open(fileName, O_RDONLY);
+    if (fd == -1) {
+        error = "cannot open file";
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0)
+        size = info.st_size;
+    if (size == expectedSize) {
+        void *p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) {
+            mapping = p;
+            mappingSize = size;
+            data = (const char *)p;
+        }
+    }
+    ::close(fd);
+#else
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in) {
+        error = "cannot open file";
+        return false;
+    }
+    buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data = buffer.data();
+    size = buffer.size();
+#endif
+
+    if (!data || size != expectedSize) {
+        error = "file size does not match the topology";
+        close();
+        return false;
+    }
+    Header header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+        error = "not a route snapshot file";
+    else if (header.numNodes != (uint32_t)expectedNumNodes || header.topologyHash != topologyHash)
+        error = "snapshot is for a different topology";
+    else if (header.checksum != checksum((const int16_t *)(data + sizeof(Header)), (size_t)expectedNumNodes * expectedNumNodes))
+        error = "checksum mismatch";
+    else {
+        matrix = (const int16_t *)(data + sizeof(Header));
+        numNodes = expectedNumNodes;
+        return true;
+    }
+    close();
+    return false;
+}
+
+bool RouteSnapshot::write(const char *fileName, uint64_t topologyHash, int numNodes, const int16_t *matrix)
+{
+    size_t count = (size_t)numNodes * numNodes;
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.numNodes = numNodes;
+    header.reserved = 0;
+    header.topologyHash = topologyHash;
+    header.checksum = checksum(matrix, count);
+
+    std::string tempFileName = std::string(fileName) + ".tmp";
+#ifndef _WIN32
+    tempFileName += "." + std::to_string(getpid());  // runs of a sweep may write concurrently
+#endif
+    FILE *f = fopen(tempFileName.c_str(), "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(matrix, sizeof(int16_t), count, f) == count;
+    ok = fclose(f) == 0 && ok;
+#ifdef _WIN32
+    remove(fileName);  // rename() does not replace existing files on Windows
+#endif
+    if (!ok || rename(tempFileName.c_str(), fileName) != 0) {
+        remove(tempFileName.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,68 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#ifndef __ROUTE_SNAPSHOT_H
+#define __ROUTE_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Next-hop matrix saved to a binary file, so that repeated runs on the same
+ * topology (parameter sweeps) can skip route computation. The file is
+ * keyed by RoutingEngine::getTopologyHash(), and carries a checksum of the
+ * matrix; open() memory-maps it and validates both.
+ *
+ * Layout (native byte order):
+ *   char magic[8] = "RTSNAP01", uint32 numNodes, uint32 reserved,
+ *   uint64 topologyHash, uint64 checksum,
+ *   int16 nextHops[numNodes * numNodes]  (row = source, column = destination)
+ */
+class RouteSnapshot
+{
+  private:
+    const int16_t *matrix = nullptr;
+    int numNodes = 0;
+    void *mapping = nullptr;  // mapped file, or nullptr
+    size_t mappingSize = 0;
+    std::vector<char> buffer; // file contents where mmap is not available
+
+  protected:
+    void close();
+
+  public:
+    RouteSnapshot() {}
+    RouteSnapshot(const RouteSnapshot&) = delete;
+    RouteSnapshot& operator=(const RouteSnapshot&) = delete;
+    ~RouteSnapshot() { close(); }
+
+    /**
+     * Maps the given file and checks that it belongs to the topology with
+     * the given hash and node count, and that the checksum matches. Returns
+     * false with the reason in error if the file does not exist or is not
+     * valid.
+     */
+    bool open(const char *fileName, uint64_t topologyHash, int numNodes, std::string& error);
+
+    /** The mapped matrix, valid while the object is open. */
+    const int16_t *getMatrix() const { return matrix; }
+
+    /**
+     * Writes a snapshot file. The file is written under a temporary name
+     * and renamed, so concurrent runs never see a partial file. Returns
+     * false if the file could not be written.
+     */
+    static bool write(const char *fileName, uint64_t topologyHash, int numNodes, const int16_t *matrix);
+
+    static uint64_t checksum(const int16_t *matrix, size_t count);
+};
+
+#endif
@@ -0,0 +1,76 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#include <algorithm>
+#include "RoutingDatabase.h"
+
+RoutingDatabase *RoutingDatabase::instance = nullptr;
+int RoutingDatabase::numUsers = 0;
+
+RoutingDatabase::RoutingDatabase(const RoutingEngine *engine, int numThreads, const char *snapshotFile, RoutingEngine::Kernel kernel)
+{
+    numNodes = engine->getNumNodes();
+
+    // addresses are normally small dense integers (often the node index),
+    // so a flat lookup array is used unless they are very sparse
+    int maxAddress = -1;
+    for (int i = 0; i < numNodes; i++)
+        maxAddress = std::max(maxAddress, engine->getAddress(i));
+    if (maxAddress < 4 * numNodes + 1024) {
+        addressToNode.assign(maxAddress + 1, -1);
+        for (int i = 0; i < numNodes; i++)
+            if (engine->getAddress(i) >= 0)
+                addressToNode[engine->getAddress(i)] = i;
+    }
+    for (int i = 0; i < numNodes; i++) {
+        int address = engine->getAddress(i);
+        if (address < 0 || address >= (int)addressToNode.size())
+            sparseAddressToNode[address] = i;
+    }
+
+    uint64_t topologyHash = 0;
+    if (snapshotFile && *snapshotFile) {
+        std::string error;
+        topologyHash = engine->getTopologyHash();
+        if (snapshot.open(snapshotFile, topologyHash, numNodes, error)) {
+            matrix = snapshot.getMatrix();
+            snapshotStatus = std::string("routes loaded from snapshot ") + snapshotFile;
+            return;
+        }
+        snapshotStatus = std::string("snapshot ") + snapshotFile + " not used (" + error + ")";
+    }
+
+    nextHops.resize((size_t)numNodes * numNodes);
+    engine->computeAllNextHops(nextHops.data(), numThreads, kernel);
+    matrix = nextHops.data();
+
+    if (snapshotFile && *snapshotFile) {
+        if (RouteSnapshot::write(snapshotFile, topologyHash, numNodes, matrix))
+            snapshotStatus += ", routes saved";
+        else
+            snapshotStatus += ", and could not be written";
+    }
+}
+
+const RoutingDatabase *RoutingDatabase::acquire(const RoutingEngine *engine, int numThreads, const char *snapshotFile,
+                                                RoutingEngine::Kernel kernel)
+{
+    if (!instance)
+        instance = new RoutingDatabase(engine, numThreads, snapshotFile, kernel);
+    numUsers++;
+    return instance;
+}
+
+void RoutingDatabase::release()
+{
+    if (--numUsers == 0) {
+        delete instance;
+        instance = nullptr;
+    }
+}
@@ -0,0 +1,87 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#ifndef __ROUTING_DATABASE_H
+#define __ROUTING_DATABASE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "RouteSnapshot.h"
+#include "RoutingEngine.h"
+
+/**
+ * Central routing database: the full N x N next-hop matrix, computed once
+ * and read in place by every Routing module in centralRouting mode. There
+ * is a single instance per simulation run; Routing modules acquire it in
+ * initialize() and release it when they are deleted.
+ */
+class RoutingDatabase
+{
+  private:
+    int numNodes = 0;
+    std::vector<int16_t> nextHops;      // computed matrix, empty if loaded from a snapshot
+    RouteSnapshot snapshot;             // mapped snapshot file, if used
+    const int16_t *matrix = nullptr;    // [source * numNodes + dest] -> gate index
+    std::string snapshotStatus;
+    std::vector<int> addressToNode;     // dense, indexed by address; -1 if unused
+    std::unordered_map<int, int> sparseAddressToNode;  // used if addresses are sparse
+
+    static RoutingDatabase *instance;
+    static int numUsers;
+
+  protected:
+    RoutingDatabase(const RoutingEngine *engine, int numThreads, const char *snapshotFile, RoutingEngine::Kernel kernel);
+
+  public:
+    /**
+     * Returns the shared database, computing it from the given engine when
+     * called for the first time, with numThreads worker threads and the
+     * given kernel (see RoutingEngine::computeAllNextHops()). The engine is not referenced
+     * afterwards. Every call must be paired with release().
+     *
+     * If snapshotFile is given, the matrix is memory-mapped from that file
+     * when it holds a valid snapshot of the same topology; otherwise it is
+     * computed and saved there for later runs (see RouteSnapshot).
+     */
+    static const RoutingDatabase *acquire(const RoutingEngine *engine, int numThreads = 1, const char *snapshotFile = nullptr,
+                                          RoutingEngine::Kernel kernel = RoutingEngine::PER_SOURCE);
+    static void release();
+
+    int getNumNodes() const { return numNodes; }
+
+    /** Returns the node index for the given address, or -1 if not found. */
+    int getNodeIndex(int address) const {
+        if (address >= 0 && address < (int)addressToNode.size())
+            return addressToNode[address];
+        if (sparseAddressToNode.empty())
+            return -1;
+        auto it = sparseAddressToNode.find(address);
+        return it == sparseAddressToNode.end() ? -1 : it->second;
+    }
+
+    /** Returns the row of next hop gate indices for the given source node. */
+    const int16_t *getRow(int source) const { return matrix + (size_t)source * numNodes; }
+
+    /** Returns the next hop gate index, or RoutingEngine::NO_ROUTE. */
+    int getNextHop(int source, int destAddress) const {
+        int dest = getNodeIndex(destAddress);
+        return dest == -1 ? RoutingEngine::NO_ROUTE : getRow(source)[dest];
+    }
+
+    /** Describes whether the snapshot file was used, for logging. */
+    const std::string& getSnapshotStatus() const { return snapshotStatus; }
+
+    size_t getMemoryUsage() const {
+        return nextHops.capacity() * sizeof(int16_t) + addressToNode.capacity() * sizeof(int);
+    }
+};
+
+#endif
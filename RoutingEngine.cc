@@ -0,0 +1,629 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <thread>
+#include "RoutingEngine.h"
+
+void RoutingEngine::build(const std::vector<int>& nodeAddresses, const std::vector<Link>& links)
+{
+    int numNodes = nodeAddresses.size();
+    addresses = nodeAddresses;
+    addressToNode.clear();
+    addressToNode.reserve(numNodes);
+    for (int i = 0; i < numNodes; i++)
+        addressToNode[addresses[i]] = i;
+
+    // counting sort of the links by source node
+    offsets.assign(numNodes + 1, 0);
+    for (const Link& link : links)
+        offsets[link.from + 1]++;
+    for (int i = 0; i < numNodes; i++)
+        offsets[i + 1] += offsets[i];
+
+    bool weighted = false;
+    for (const Link& link : links)
+        if (link.weight != 1)
+            weighted = true;
+
+    targets.resize(links.size());
+    gates.resize(links.size());
+    weights.assign(weighted ? links.size() : 0, 1);
+    std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+    std::vector<int> linkPositions;
+    linkPositions.reserve(links.size());
+    for (const Link& link : links) {
+        int pos = fill[link.from]++;
+        linkPositions.push_back(pos);
+        targets[pos] = link.to;
+        gates[pos] = link.gateIndex;
+        if (weighted)
+            weights[pos] = link.weight;
+    }
+
+    inOffsets.assign(numNodes + 1, 0);
+    for (const Link& link : links)
+        inOffsets[link.to + 1]++;
+    for (int i = 0; i < numNodes; i++)
+        inOffsets[i + 1] += inOffsets[i];
+
+    inSources.resize(links.size());
+    inGates.resize(links.size());
+    inWeights.assign(weighted ? links.size() : 0, 1);
+    inLinks.resize(links.size());
+    fill.assign(inOffsets.begin(), inOffsets.end() - 1);
+    for (size_t i = 0; i < links.size(); i++) {
+        const Link& link = links[i];
+        int pos = fill[link.to]++;
+        inSources[pos] = link.from;
+        inGates[pos] = link.gateIndex;
+        inLinks[pos] = linkPositions[i];
+        if (weighted)
+            inWeights[pos] = link.weight;
+    }
+    columnCache.clear();
+}
+
+template <typename T>
+static void hashArray(uint64_t& hash, const std::vector<T>& array)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(array.data());
+    for (size_t i = 0; i < array.size() * sizeof(T); i++)
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    hash = (hash ^ array.size()) * 0x100000001b3ULL;
+}
+
+uint64_t RoutingEngine::getTopologyHash() const
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hashArray(hash, addresses);
+    hashArray(hash, offsets);
+    hashArray(hash, targets);
+    hashArray(hash, gates);
+    hashArray(hash, weights);
+    return hash;
+}
+
+int RoutingEngine::getNodeIndex(int address) const
+{
+    auto it = addressToNode.find(address);
+    return it == addressToNode.end() ? -1 : it->second;
+}
+
+size_t RoutingEngine::getMemoryUsage() const
+{
+    // hash map nodes: key, value, next pointer and cached hash, plus a bucket pointer
+    const size_t mapNodeSize = 4 * sizeof(void *);
+    size_t bytes = addresses.capacity() * sizeof(int) + addressToNode.size() * mapNodeSize +
+                   (offsets.capacity() + targets.capacity() + inOffsets.capacity() + inSources.capacity() + inLinks.capacity()) * sizeof(int) +
+                   (gates.capacity() + inGates.capacity()) * sizeof(int16_t) +
+                   (weights.capacity() + inWeights.capacity()) * sizeof(double);
+    for (const auto& column : columnCache)
+        bytes += mapNodeSize + column.second.capacity() * sizeof(int16_t);
+    return bytes;
+}
+
+void RoutingEngine::computeNextHopsFrom(int source, std::vector<int16_t>& nextHops) const
+{
+    numSearches.fetch_add(1, std::memory_order_relaxed);
+    if (isWeighted())
+        dijkstraFrom(source, nextHops);
+    else
+        bfsFrom(source, nextHops);
+}
+
+void RoutingEngine::computeNextHopsWithin(int source, const int *members, int numMembers, const int *localIndex,
+                                          std::vector<int16_t>& nextHops) const
+{
+    numSearches.fetch_add(1, std::memory_order_relaxed);
+    if (isWeighted())
+        dijkstraWithin(source, members, numMembers, localIndex, nextHops);
+    else
+        bfsWithin(source, members, numMembers, localIndex, nextHops);
+}
+
+void RoutingEngine::bfsFrom(int source, std::vector<int16_t>& nextHops) const
+{
+    int numNodes = getNumNodes();
+    nextHops.assign(numNodes, NO_ROUTE);
+
+    // BFS from the source; every node inherits the first hop of the node
+    // it was discovered from, so one traversal yields the whole row
+    std::vector<char> visited(numNodes, 0);
+    std::vector<int> queue;
+    queue.reserve(numNodes);
+    visited[source] = 1;
+
+    for (int e = offsets[source]; e < offsets[source + 1]; e++) {
+        int neighbor = targets[e];
+        if (!visited[neighbor]) {
+            visited[neighbor] = 1;
+            nextHops[neighbor] = gates[e];
+            queue.push_back(neighbor);
+        }
+    }
+
+    for (size_t head = 0; head < queue.size(); head++) {
+        int node = queue[head];
+        for (int e = offsets[node]; e < offsets[node + 1]; e++) {
+            int neighbor = targets[e];
+            if (!visited[neighbor]) {
+                visited[neighbor] = 1;
+                nextHops[neighbor] = nextHops[node];
+                queue.push_back(neighbor);
+            }
+        }
+    }
+}
+
+const std::vector<int16_t>& RoutingEngine::computeNextHopsTo(int dest) const
+{
+    auto it = columnCache.find(dest);
+    if (it != columnCache.end())
+        return it->second;
+
+    std::vector<int16_t>& nextHops = columnCache[dest];
+    computeNextHopsToAny(std::vector<int>(1, dest), nextHops);
+    return nextHops;
+}
+
+void RoutingEngine::computeNextHopsToAny(const std::vector<int>& dests, std::vector<int16_t>& nextHops) const
+{
+    numSearches.fetch_add(1, std::memory_order_relaxed);
+    if (isWeighted())
+        dijkstraTo(dests, nextHops);
+    else
+        bfsTo(dests, nextHops);
+}
+
+void RoutingEngine::bfsTo(const std::vector<int>& dests, std::vector<int16_t>& nextHops) const
+{
+    int numNodes = getNumNodes();
+    nextHops.assign(numNodes, NO_ROUTE);
+
+    // BFS from the destinations along incoming links; a node discovered via
+    // its link towards an already discovered node uses that link's gate
+    std::vector<char> visited(numNodes, 0);
+    std::vector<int> queue;
+    queue.reserve(numNodes);
+    for (int dest : dests) {
+        if (!visited[dest]) {
+            visited[dest] = 1;
+            queue.push_back(dest);
+        }
+    }
+
+    for (size_t head = 0; head < queue.size(); head++) {
+        int node = queue[head];
+        for (int e = inOffsets[node]; e < inOffsets[node + 1]; e++) {
+            int neighbor = inSources[e];
+            if (!visited[neighbor]) {
+                visited[neighbor] = 1;
+                nextHops[neighbor] = inGates[e];
+                queue.push_back(neighbor);
+            }
+        }
+    }
+}
+
+static inline int lowestSetBit(uint64_t x)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int bit = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+typedef std::pair<double, int> HeapEntry;  // distance, node
+typedef std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> MinHeap;
+
+void RoutingEngine::dijkstraFrom(int source, std::vector<int16_t>& nextHops) const
+{
+    int numNodes = getNumNodes();
+    nextHops.assign(numNodes, NO_ROUTE);
+
+    // binary heap with lazy deletion: stale entries are skipped when popped
+    std::vector<double> dist(numNodes, std::numeric_limits<double>::infinity());
+    MinHeap heap;
+    dist[source] = 0;
+    heap.push(HeapEntry(0, source));
+
+    while (!heap.empty()) {
+        HeapEntry top = heap.top();
+        heap.pop();
+        int node = top.second;
+        if (top.first > dist[node])
+            continue;
+        for (int e = offsets[node]; e < offsets[node + 1]; e++) {
+            int neighbor = targets[e];
+            double d = top.first + weights[e];
+            if (d < dist[neighbor]) {
+                dist[neighbor] = d;
+                nextHops[neighbor] = (node == source) ? gates[e] : nextHops[node];
+                heap.push(HeapEntry(d, neighbor));
+            }
+        }
+    }
+}
+
+void RoutingEngine::bfsWithin(int source, const int *members, int numMembers, const int *localIndex,
+                              std::vector<int16_t>& nextHops) const
+{
+    // like bfsFrom(), over the members only: a neighbor is entered if its
+    // local index points back to it in this member list
+    auto toLocal = [&](int node) {
+        int k = localIndex[node];
+        return (k < numMembers && members[k] == node) ? k : -1;
+    };
+    nextHops.assign(numMembers, NO_ROUTE);
+    std::vector<char> visited(numMembers, 0);
+    std::vector<int> queue;  // node indices
+    queue.reserve(numMembers);
+    visited[toLocal(source)] = 1;
+    queue.push_back(source);
+
+    for (size_t head = 0; head < queue.size(); head++) {
+        int node = queue[head];
+        int16_t firstHop = node == source ? NO_ROUTE : nextHops[toLocal(node)];
+        for (int e = offsets[node]; e < offsets[node + 1]; e++) {
+            int k = toLocal(targets[e]);
+            if (k != -1 && !visited[k]) {
+                visited[k] = 1;
+                nextHops[k] = node == source ? gates[e] : firstHop;
+                queue.push_back(targets[e]);
+            }
+        }
+    }
+}
+
+void RoutingEngine::dijkstraWithin(int source, const int *members, int numMembers, const int *localIndex,
+                                   std::vector<int16_t>& nextHops) const
+{
+    // like dijkstraFrom(), over the members only; the heap holds local indices
+    auto toLocal = [&](int node) {
+        int k = localIndex[node];
+        return (k < numMembers && members[k] == node) ? k : -1;
+    };
+    nextHops.assign(numMembers, NO_ROUTE);
+    std::vector<double> dist(numMembers, std::numeric_limits<double>::infinity());
+    MinHeap heap;
+    int localSource = toLocal(source);
+    dist[localSource] = 0;
+    heap.push(HeapEntry(0, localSource));
+
+    while (!heap.empty()) {
+        HeapEntry top = heap.top();
+        heap.pop();
+        int k = top.second;
+        if (top.first > dist[k])
+            continue;
+        int node = members[k];
+        for (int e = offsets[node]; e < offsets[node + 1]; e++) {
+            int neighbor = toLocal(targets[e]);
+            if (neighbor == -1)
+                continue;
+            double d = top.first + weights[e];
+            if (d < dist[neighbor]) {
+                dist[neighbor] = d;
+                nextHops[neighbor] = (k == localSource) ? gates[e] : nextHops[k];
+                heap.push(HeapEntry(d, neighbor));
+            }
+        }
+    }
+}
+
+void RoutingEngine::computeDistancesFrom(int source, std::vector<double>& dist) const
+{
+    numSearches.fetch_add(1, std::memory_order_relaxed);
+    int numNodes = getNumNodes();
+    dist.assign(numNodes, std::numeric_limits<double>::infinity());
+    dist[source] = 0;
+
+    if (!isWeighted()) {
+        // BFS; the distance array doubles as the visited marker
+        std::vector<int> queue;
+        queue.reserve(numNodes);
+        queue.push_back(source);
+        for (size_t head = 0; head < queue.size(); head++) {
+            int node = queue[head];
+            for (int e = offsets[node]; e < offsets[node + 1]; e++) {
+                int neighbor = targets[e];
+                if (dist[neighbor] == std::numeric_limits<double>::infinity()) {
+                    dist[neighbor] = dist[node] + 1;
+                    queue.push_back(neighbor);
+                }
+            }
+        }
+        return;
+    }
+
+    MinHeap heap;
+    heap.push(HeapEntry(0, source));
+    while (!heap.empty()) {
+        HeapEntry top = heap.top();
+        heap.pop();
+        int node = top.second;
+        if (top.first > dist[node])
+            continue;
+        for (int e = offsets[node]; e < offsets[node + 1]; e++) {
+            double d = top.first + weights[e];
+            if (d < dist[targets[e]]) {
+                dist[targets[e]] = d;
+                heap.push(HeapEntry(d, targets[e]));
+            }
+        }
+    }
+}
+
+void RoutingEngine::dijkstraTo(const std::vector<int>& dests, std::vector<int16_t>& nextHops) const
+{
+    int numNodes = getNumNodes();
+    nextHops.assign(numNodes, NO_ROUTE);
+
+    std::vector<double> dist(numNodes, std::numeric_limits<double>::infinity());
+    MinHeap heap;
+    for (int dest : dests) {
+        dist[dest] = 0;
+        heap.push(HeapEntry(0, dest));
+    }
+
+    while (!heap.empty()) {
+        HeapEntry top = heap.top();
+        heap.pop();
+        int node = top.second;
+        if (top.first > dist[node])
+            continue;
+        for (int e = inOffsets[node]; e < inOffsets[node + 1]; e++) {
+            int neighbor = inSources[e];
+            double d = top.first + inWeights[e];
+            if (d < dist[neighbor]) {
+                dist[neighbor] = d;
+                nextHops[neighbor] = inGates[e];
+                heap.push(HeapEntry(d, neighbor));
+            }
+        }
+    }
+}
+
+void RoutingEngine::computeMultiPathsFrom(int source, std::vector<PathSet>& paths) const
+{
+    numSearches.fetch_add(1, std::memory_order_relaxed);
+    // every node carries the set of source links that start a shortest path
+    // towards it, as a bitmask over the source's link positions; a node's
+    // set is the union of the sets of its shortest-path predecessors
+    int numNodes = getNumNodes();
+    int numSourceLinks = std::min(offsets[source + 1] - offsets[source], 64);
+    std::vector<uint64_t> masks(numNodes, 0);
+    std::vector<double> dist(numNodes, std::numeric_limits<double>::infinity());
+    dist[source] = 0;
+
+    auto relax = [&](int node, int e, double d) {
+        int neighbor = targets[e];
+        uint64_t mask = (node == source) ? (e - offsets[source] < numSourceLinks ? 1ULL << (e - offsets[source]) : 0) : masks[node];
+        const double epsilon = 1e-9 * std::max(1.0, d);
+        if (d < dist[neighbor] - epsilon) {
+            dist[neighbor] = d;
+            masks[neighbor] = mask;
+            return true;
+        }
+        if (d <= dist[neighbor] + epsilon)
+            masks[neighbor] |= mask;
+        return false;
+    };
+
+    if (!isWeighted()) {
+        std::vector<int> queue;
+        queue.reserve(numNodes);
+        queue.push_back(source);
+        for (size_t head = 0; head < queue.size(); head++) {
+            int node = queue[head];
+            for (int e = offsets[node]; e < offsets[node + 1]; e++)
+                if (relax(node, e, dist[node] + 1))
+                    queue.push_back(targets[e]);
+        }
+    }
+    else {
+        MinHeap heap;
+        heap.push(HeapEntry(0, source));
+        while (!heap.empty()) {
+            HeapEntry top = heap.top();
+            heap.pop();
+            int node = top.second;
+            if (top.first > dist[node])
+                continue;
+            for (int e = offsets[node]; e < offsets[node + 1]; e++)
+                if (relax(node, e, top.first + weights[e]))
+                    heap.push(HeapEntry(dist[targets[e]], targets[e]));
+        }
+    }
+    masks[source] = 0;
+    pathSetsFromMasks(source, masks, paths);
+}
+
+void RoutingEngine::pathSetsFromMasks(int source, const std::vector<uint64_t>& masks, std::vector<PathSet>& paths) const
+{
+    int numNodes = getNumNodes();
+    paths.assign(numNodes, PathSet());
+    for (int node = 0; node < numNodes; node++) {
+        PathSet& set = paths[node];
+        for (uint64_t mask = masks[node]; mask != 0 && set.count < MAX_PATHS; mask &= mask - 1) {
+            int bit = lowestSetBit(mask);
+            int16_t gate = gates[offsets[source] + bit];
+            if (std::find(set.gates, set.gates + set.count, gate) == set.gates + set.count)
+                set.gates[set.count++] = gate;
+        }
+    }
+}
+
+void RoutingEngine::bitsetBfsTo(const int *dests, int numDests, int16_t *matrix, int firstColumn) const
+{
+    // Multi-source BFS over the reverse graph: every node carries a bitset
+    // with one bit per destination of the batch. A level pushes the
+    // frontier bits of each node to the senders of its incoming links with
+    // word-wide ANDs/ORs; a sender that gets a bit for the first time takes
+    // that link as its next hop towards the destination. The bits are
+    // collected per link, and decoded into gate indices row by row at the
+    // end; the next hops towards dests[j] are stored in column firstColumn+j.
+    numSearches.fetch_add(numDests, std::memory_order_relaxed);
+    int numNodes = getNumNodes();
+    const int W = BITSET_WORDS;
+    std::vector<uint64_t> seen((size_t)numNodes * W, 0);
+    std::vector<uint64_t> frontier((size_t)numNodes * W, 0);
+    std::vector<uint64_t> next((size_t)numNodes * W, 0);
+    std::vector<uint64_t> viaLink((size_t)getNumLinks() * W, 0);  // indexed by forward link position
+    std::vector<int> active, nextActive;
+
+    for (int j = 0; j < numDests; j++) {
+        uint64_t *bits = &frontier[(size_t)dests[j] * W];
+        if (std::all_of(bits, bits + W, [](uint64_t word) { return word == 0; }))
+            active.push_back(dests[j]);
+        bits[j / 64] |= 1ULL << (j % 64);
+        seen[(size_t)dests[j] * W + j / 64] |= 1ULL << (j % 64);
+    }
+
+    while (!active.empty()) {
+        nextActive.clear();
+        for (int node : active) {
+            const uint64_t *nodeBits = &frontier[(size_t)node * W];
+            for (int e = inOffsets[node]; e < inOffsets[node + 1]; e++) {
+                int sender = inSources[e];
+                const uint64_t *senderSeen = &seen[(size_t)sender * W];
+                uint64_t *senderNext = &next[(size_t)sender * W];
+                uint64_t newBits[W];
+                uint64_t any = 0, pending = 0;
+                for (int k = 0; k < W; k++) {
+                    newBits[k] = nodeBits[k] & ~(senderSeen[k] | senderNext[k]);
+                    any |= newBits[k];
+                    pending |= senderNext[k];
+                }
+                if (!any)
+                    continue;
+                if (!pending)
+                    nextActive.push_back(sender);
+                uint64_t *linkBits = &viaLink[(size_t)inLinks[e] * W];
+                for (int k = 0; k < W; k++) {
+                    senderNext[k] |= newBits[k];
+                    linkBits[k] |= newBits[k];
+                }
+            }
+        }
+        for (int node : active)
+            std::fill_n(&frontier[(size_t)node * W], W, 0);
+        for (int node : nextActive)
+            for (int k = 0; k < W; k++)
+                seen[(size_t)node * W + k] |= next[(size_t)node * W + k];
+        frontier.swap(next);
+        active.swap(nextActive);
+    }
+
+    for (int node = 0; node < numNodes; node++) {
+        int16_t *row = matrix + (size_t)node * numNodes + firstColumn;
+        std::fill_n(row, numDests, (int16_t)NO_ROUTE);
+        for (int e = offsets[node]; e < offsets[node + 1]; e++)
+            for (int k = 0; k < W; k++)
+                for (uint64_t bits = viaLink[(size_t)e * W + k]; bits; bits &= bits - 1)
+                    row[k * 64 + lowestSetBit(bits)] = gates[e];
+    }
+}
+
+// Calls fn(buffer, i) for i in [0, numItems): workers pick the next
+// unprocessed item; buffer is a per-worker scratch vector
+template <typename F>
+static void parallelFor(int numItems, int numThreads, F fn)
+{
+    numThreads = std::max(1, std::min(numThreads, numItems));
+    std::atomic<int> nextItem(0);
+    auto worker = [&]() {
+        std::vector<int16_t> buffer;
+        for (int i; (i = nextItem++) < numItems; )
+            fn(buffer, i);
+    };
+
+    if (numThreads == 1) {
+        worker();
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; i++)
+        threads.emplace_back(worker);
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+void RoutingEngine::computeAllNextHops(int16_t *matrix, int numThreads, Kernel kernel) const
+{
+    int numNodes = getNumNodes();
+    if (numThreads <= 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    // the bitset kernel processes the destinations in batches; every batch
+    // is grown by a BFS from the lowest unassigned node over the unassigned
+    // nodes, so it is a compact region of the graph, and its bits spread
+    // over few BFS levels at every node. Columns are written in batch order,
+    // so that a batch fills a contiguous slice of every row, and the rows
+    // are permuted into node order at the end.
+    bool bitset = kernel == BITSET_BFS && !isWeighted();
+    int batchSize = bitset ? 64 * BITSET_WORDS : 1;
+    std::vector<int> order;
+    if (bitset) {
+        std::vector<char> assigned(numNodes, 0);
+        std::vector<int> queue;
+        order.reserve(numNodes);
+        for (int root = 0; root < numNodes; root++) {
+            if (assigned[root])
+                continue;
+            size_t batchEnd = (order.size() / batchSize + 1) * batchSize;  // fill up the current batch
+            queue.assign(1, root);
+            for (size_t head = 0; head < queue.size() && order.size() < batchEnd; head++) {
+                int node = queue[head];
+                if (assigned[node])
+                    continue;
+                assigned[node] = 1;
+                order.push_back(node);
+                for (int e = offsets[node]; e < offsets[node + 1]; e++)
+                    if (!assigned[targets[e]])
+                        queue.push_back(targets[e]);
+            }
+        }
+    }
+    int numBatches = (numNodes + batchSize - 1) / batchSize;
+
+    // rows (or batches of columns) do not overlap, so no locking is needed
+    // on the matrix
+    parallelFor(numBatches, numThreads, [&](std::vector<int16_t>& row, int batch) {
+        if (bitset) {
+            int first = batch * batchSize;
+            bitsetBfsTo(order.data() + first, std::min(batchSize, numNodes - first), matrix, first);
+        }
+        else {
+            computeNextHopsFrom(batch, row);
+            std::copy(row.begin(), row.end(), matrix + (size_t)batch * numNodes);
+        }
+    });
+    if (!bitset)
+        return;
+
+    // column p of every row holds the next hop towards order[p]
+    parallelFor(numNodes, numThreads, [&](std::vector<int16_t>& row, int source) {
+        int16_t *matrixRow = matrix + (size_t)source * numNodes;
+        row.assign(matrixRow, matrixRow + numNodes);
+        for (int p = 0; p < numNodes; p++)
+            matrixRow[order[p]] = row[p];
+    });
+}
@@ -0,0 +1,196 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#ifndef __ROUTING_ENGINE_H
+#define __ROUTING_ENGINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Route computation over a compact (CSR) copy of the router graph.
+ *
+ * The graph is extracted once and shared by all Routing modules; every
+ * router then obtains its next hops with a single BFS from itself, instead
+ * of one cTopology shortest path computation per destination. If links
+ * have non-unit weights, Dijkstra's algorithm with a binary heap is used
+ * instead of BFS. The class does not depend on the simulation kernel, so
+ * it can also be used from standalone tools.
+ */
+class RoutingEngine
+{
+  public:
+    static constexpr int NO_ROUTE = -1;
+    static constexpr int MAX_PATHS = 4;  // max number of equal-cost next hops per destination
+    static constexpr int BITSET_WORDS = 4;  // bitsetBfsTo() batch: 64 * BITSET_WORDS destinations
+
+    /** Algorithm of computeAllNextHops() */
+    enum Kernel {
+        PER_SOURCE,  // one BFS (or Dijkstra run) per source row
+        BITSET_BFS   // bit-parallel BFS over batches of destinations; unweighted graphs only
+    };
+
+    /** Set of equal-cost next hop gates towards one destination */
+    struct PathSet {
+        uint8_t count = 0;
+        int16_t gates[MAX_PATHS];
+    };
+
+    struct Link {
+        int from;       // node index
+        int to;         // node index
+        int gateIndex;  // index of the output gate at the "from" node
+        double weight = 1;  // link cost, must be positive
+    };
+
+  private:
+    std::vector<int> addresses;   // node index -> address
+    std::unordered_map<int, int> addressToNode;
+    std::vector<int> offsets;     // CSR row offsets, size numNodes+1
+    std::vector<int> targets;     // CSR column (neighbor node index) per link
+    std::vector<int16_t> gates;   // output gate index per link
+    std::vector<double> weights;  // link cost per link; empty if all are 1
+
+    // reverse adjacency (incoming links), for routes towards one destination
+    std::vector<int> inOffsets;
+    std::vector<int> inSources;   // node index at the sending end of the link
+    std::vector<int16_t> inGates; // output gate index at the sending end
+    std::vector<double> inWeights;
+    std::vector<int> inLinks;     // position of the same link in the forward CSR arrays
+
+    // next hops towards a destination, memoized by computeNextHopsTo()
+    mutable std::unordered_map<int, std::vector<int16_t>> columnCache;
+
+    // shortest path trees computed so far (one per source or destination
+    // set, counted by all the compute methods)
+    mutable std::atomic<uint64_t> numSearches{0};
+
+  protected:
+    void bfsFrom(int source, std::vector<int16_t>& nextHops) const;
+    void dijkstraFrom(int source, std::vector<int16_t>& nextHops) const;
+    // computeNextHopsWithin(): the traversal is limited to the group, and
+    // nextHops and the work arrays are indexed by position in members
+    void bfsWithin(int source, const int *members, int numMembers, const int *localIndex, std::vector<int16_t>& nextHops) const;
+    void dijkstraWithin(int source, const int *members, int numMembers, const int *localIndex, std::vector<int16_t>& nextHops) const;
+    void bfsTo(const std::vector<int>& dests, std::vector<int16_t>& nextHops) const;
+    void dijkstraTo(const std::vector<int>& dests, std::vector<int16_t>& nextHops) const;
+    void pathSetsFromMasks(int source, const std::vector<uint64_t>& masks, std::vector<PathSet>& paths) const;
+    void bitsetBfsTo(const int *dests, int numDests, int16_t *matrix, int firstColumn) const;
+
+  public:
+    /**
+     * Builds the CSR adjacency from the given node addresses and links.
+     * Links may come in any order.
+     */
+    void build(const std::vector<int>& addresses, const std::vector<Link>& links);
+
+    int getNumNodes() const { return (int)addresses.size(); }
+    int getNumLinks() const { return (int)targets.size(); }
+    int getAddress(int node) const { return addresses[node]; }
+    bool isWeighted() const { return !weights.empty(); }
+    uint64_t getNumSearches() const { return numSearches.load(std::memory_order_relaxed); }
+
+    /** Bytes held by the graph and the cached columns (approximate for the hash maps). */
+    size_t getMemoryUsage() const;
+
+    /**
+     * Returns a 64-bit hash (FNV-1a) of the addresses and the links,
+     * including gate indices and weights. Graphs with the same hash have
+     * the same routes.
+     */
+    uint64_t getTopologyHash() const;
+
+    /**
+     * Read-only access to the CSR arrays, for incremental algorithms. Links
+     * are identified by their position in the forward arrays; the outgoing
+     * links of a node are [getLinkBegin(node), getLinkEnd(node)).
+     */
+    int getLinkBegin(int node) const { return offsets[node]; }
+    int getLinkEnd(int node) const { return offsets[node + 1]; }
+    int getLinkTarget(int link) const { return targets[link]; }
+    int getLinkGate(int link) const { return gates[link]; }
+    double getLinkWeight(int link) const { return weights.empty() ? 1 : weights[link]; }
+    int getInLinkBegin(int node) const { return inOffsets[node]; }
+    int getInLinkEnd(int node) const { return inOffsets[node + 1]; }
+    int getInLink(int pos) const { return inLinks[pos]; }
+
+    /** Returns the node index for the given address, or -1 if not found. */
+    int getNodeIndex(int address) const;
+
+    /**
+     * Computes the next hop gate index from the given node towards every
+     * node, with one BFS (or Dijkstra run, for weighted graphs). Entries for
+     * the source itself and for unreachable nodes are NO_ROUTE. The result
+     * is indexed by node index.
+     */
+    void computeNextHopsFrom(int source, std::vector<int16_t>& nextHops) const;
+
+    /**
+     * Computes the next hop gate index from every node towards the given
+     * destination, with one BFS (or Dijkstra run) over the reverse graph.
+     * The result is indexed by node index, and it is cached: later calls for
+     * the same destination return the stored row.
+     */
+    const std::vector<int16_t>& computeNextHopsTo(int dest) const;
+
+    /**
+     * Like computeNextHopsFrom(), but only paths that stay within a group of
+     * nodes are considered, and the cost is proportional to the size of the
+     * group, not of the graph. members lists the node indices of the group,
+     * the source among them; localIndex (indexed by node index) gives the
+     * position of every node in the member list of its own group, so node n
+     * is in this group iff localIndex[n] < numMembers and
+     * members[localIndex[n]] == n. The result has numMembers entries, in
+     * the order of members; the source and members not reachable inside
+     * the group get NO_ROUTE.
+     */
+    void computeNextHopsWithin(int source, const int *members, int numMembers, const int *localIndex,
+                               std::vector<int16_t>& nextHops) const;
+
+    /**
+     * Computes the next hop gate index from every node towards the nearest
+     * of the given destination nodes, with one multi-source search over the
+     * reverse graph. Destinations themselves get NO_ROUTE. Not cached.
+     */
+    void computeNextHopsToAny(const std::vector<int>& dests, std::vector<int16_t>& nextHops) const;
+
+    /**
+     * Computes the path cost from the given node to every node (hop count
+     * for unweighted graphs). Unreachable nodes get infinity.
+     */
+    void computeDistancesFrom(int source, std::vector<double>& dist) const;
+
+    /**
+     * Like computeNextHopsFrom(), but collects all equal-cost next hops
+     * towards every node (at most MAX_PATHS, taken from the first 64 links
+     * of the source). Unreachable nodes and the source get an empty set.
+     */
+    void computeMultiPathsFrom(int source, std::vector<PathSet>& paths) const;
+
+    /**
+     * Computes the next hops of all nodes into the given preallocated
+     * numNodes x numNodes matrix (row = source, column = destination).
+     * Rows are independent, so they are distributed over numThreads worker
+     * threads; numThreads <= 0 means one thread per hardware core. This
+     * method is safe to run concurrently with other const methods except
+     * computeNextHopsTo().
+     *
+     * With BITSET_BFS, columns are computed instead, up to 64 * BITSET_WORDS
+     * destinations per pass, so that a frontier expansion step handles all
+     * of them with a few word operations per link. The routes are shortest
+     * paths like with PER_SOURCE, but ties between equal-cost next hops may
+     * be broken differently. Weighted graphs always use PER_SOURCE.
+     */
+    void computeAllNextHops(int16_t *matrix, int numThreads = 1, Kernel kernel = PER_SOURCE) const;
+};
+
+#endif
@@ -0,0 +1,96 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include "RoutingProfiler.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+RoutingProfiler *RoutingProfiler::instance = nullptr;
+int RoutingProfiler::numUsers = 0;
+
+RoutingProfiler *RoutingProfiler::acquire()
+{
+    if (!instance)
+        instance = new RoutingProfiler();
+    numUsers++;
+    instance->numRouters++;
+    return instance;
+}
+
+void RoutingProfiler::release()
+{
+    if (--numUsers == 0) {
+        delete instance;
+        instance = nullptr;
+    }
+}
+
+const char *RoutingProfiler::getPhaseName(Phase phase)
+{
+    static const char *const names[] = { "extract", "compute", "tableFill", "dissemination" };
+    return names[phase];
+}
+
+void RoutingProfiler::setMode(const char *routingMode, const char *routingKernel)
+{
+    if (mode.empty()) {
+        mode = routingMode;
+        kernel = routingKernel;
+    }
+}
+
+bool RoutingProfiler::routerReady(size_t tableBytes)
+{
+    numReady++;
+    tableBytesTotal += tableBytes;
+    tableBytesMax = std::max(tableBytesMax, tableBytes);
+    return numReady == numRouters;
+}
+
+uint64_t RoutingProfiler::getNumPathComputations() const
+{
+    uint64_t sum = 0;
+    for (const auto& entry : engineSearches)
+        sum += entry.second;
+    return sum;
+}
+
+size_t RoutingProfiler::getPeakRss()
+{
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss;  // bytes
+#else
+    return (size_t)usage.ru_maxrss * 1024;  // kilobytes
+#endif
+#endif
+}
+
+std::string RoutingProfiler::getSummary() const
+{
+    char line[512];
+    snprintf(line, sizeof(line),
+             "routing-profile: routers=%d ready=%d mode=%s kernel=%s extract_s=%.6f compute_s=%.6f table_fill_s=%.6f "
+             "dissemination_s=%.6f path_computations=%llu table_bytes_total=%llu table_bytes_max=%llu "
+             "shared_bytes_peak=%llu peak_rss_bytes=%llu",
+             numRouters, numReady, mode.c_str(), kernel.c_str(), phaseTimes[EXTRACT], phaseTimes[COMPUTE],
+             phaseTimes[TABLE_FILL], phaseTimes[DISSEMINATION], (unsigned long long)getNumPathComputations(),
+             (unsigned long long)tableBytesTotal, (unsigned long long)tableBytesMax,
+             (unsigned long long)sharedBytesPeak, (unsigned long long)getPeakRss());
+    return line;
+}
@@ -0,0 +1,127 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#ifndef __ROUTING_PROFILER_H
+#define __ROUTING_PROFILER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include "RoutingEngine.h"
+
+/**
+ * Startup profile of the routing subsystem: wall time per phase, summed
+ * over all routers, the number of shortest path trees computed, and the
+ * memory of the per-router tables and of the shared structures. There is
+ * one shared instance per process, i.e. per partition under parallel
+ * simulation; Routing modules acquire it in initialize() and release it
+ * when they are deleted.
+ */
+class RoutingProfiler
+{
+  public:
+    enum Phase {
+        EXTRACT,        // topology extraction (or reading/building the graph)
+        COMPUTE,        // route computation, including shared matrices and areas
+        TABLE_FILL,     // building the per-router next-hop tables
+        DISSEMINATION,  // centralRouting with inband distribution: encoding, decoding, flooding
+        NUM_PHASES
+    };
+
+    /** Adds the wall time of its scope to a phase; does nothing without a profiler. */
+    class Timer
+    {
+      private:
+        RoutingProfiler *profiler;
+        Phase phase;
+        std::chrono::steady_clock::time_point start;
+
+      public:
+        Timer(RoutingProfiler *profiler, Phase phase) : profiler(profiler), phase(phase) {
+            if (profiler)
+                start = std::chrono::steady_clock::now();
+        }
+        ~Timer() {
+            if (profiler)
+                profiler->add(phase, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+    };
+
+  private:
+    double phaseTimes[NUM_PHASES] = {};
+    std::string mode, kernel;
+    int numRouters = 0;  // routers of this partition that acquired the profiler
+    int numReady = 0;    // routers with their routes in place
+    bool reported = false;
+    bool recorded = false;
+    std::map<const RoutingEngine *, uint64_t> engineSearches;  // latest search count per engine
+    uint64_t tableBytesTotal = 0;
+    size_t tableBytesMax = 0;
+    size_t sharedBytesPeak = 0;
+
+    static RoutingProfiler *instance;
+    static int numUsers;
+
+  public:
+    /** Every call counts one more router that will report routerReady(). */
+    static RoutingProfiler *acquire();
+    static void release();
+
+    static const char *getPhaseName(Phase phase);
+
+    /** The routing mode and kernel, for the summary; the first call wins. */
+    void setMode(const char *mode, const char *kernel);
+
+    void add(Phase phase, double seconds) { phaseTimes[phase] += seconds; }
+
+    /** Takes note of the number of searches done by the engine so far. */
+    void noteEngine(const RoutingEngine *engine) { engineSearches[engine] = engine->getNumSearches(); }
+
+    /** Memory currently held by the shared structures; the peak is kept. */
+    void noteSharedMemory(size_t bytes) { sharedBytesPeak = std::max(sharedBytesPeak, bytes); }
+
+    /**
+     * Called once per router when its routes are in place, with the memory
+     * of its table. Returns true for the last router, when the summary is due.
+     */
+    bool routerReady(size_t tableBytes);
+
+    bool isReported() const { return reported; }
+    void setReported() { reported = true; }
+
+    /** True for the first caller only: the router that records the profile scalars. */
+    bool claimRecording() {
+        if (recorded)
+            return false;
+        recorded = true;
+        return true;
+    }
+
+    int getNumRouters() const { return numRouters; }
+    int getNumReady() const { return numReady; }
+    double getPhaseTime(Phase phase) const { return phaseTimes[phase]; }
+    uint64_t getNumPathComputations() const;
+    uint64_t getTableBytesTotal() const { return tableBytesTotal; }
+    size_t getTableBytesMax() const { return tableBytesMax; }
+    size_t getSharedBytesPeak() const { return sharedBytesPeak; }
+
+    /** Peak resident set size of the process in bytes, 0 where unknown. */
+    static size_t getPeakRss();
+
+    /**
+     * One line of key=value fields, e.g. for benchmark dashboards:
+     * "routing-profile: routers=... mode=... extract_s=... ..."
+     */
+    std::string getSummary() const;
+};
+
+#endif
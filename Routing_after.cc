@@ -11,149 +11,1071 @@
 #pragma warning(disable:4786)
 #endif
 
-#include <map>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
 #include <omnetpp.h>
+#include "NextHopTable.h"
+#include "AreaRoutes.h"
+#include "DynamicRouting.h"
+#include "FastMode.h"
 #include "Packet_m.h"
+#include "RouteUpdate_m.h"
+#include "RoutingDatabase.h"
+#include "ResultStream.h"
+#include "RoutingEngine.h"
+#include "RoutingProfiler.h"
+#include "SignalMask.h"
+#include "TopologyCache.h"
 
 using namespace omnetpp;
 
+/**
+ * Packet and byte counters of one output port (or of local delivery, or
+ * of drops), updated with plain increments on every forwarded packet.
+ */
+struct PortCounters {
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+
+    void count(int64_t byteLength) {
+        packets++;
+        bytes += byteLength;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const PortCounters& counters)
+{
+    return os << counters.packets << " pk, " << counters.bytes << " B";
+}
+
 /**
  * Demonstrates static routing, utilizing the cTopology class.
  */
-class Routing : public cSimpleModule
+class Routing : public cSimpleModule, public cListener, public DynamicRouting::IListener
 {
   private:
     int myAddress;
 
-    typedef std::map<int, int> RoutingTable;  // destaddr -> gateindex
-    RoutingTable rtable;
+    // ✅ CHANGE: Flat destaddr -> gateindex table instead of std::map
+    // ✔️ IMPACT: One array index per forwarded packet, 2 bytes per entry
+    NextHopTable rtable;
+
+    // shared topology, held from initialization stage 0 until routes are
+    // computed (or until the end of the simulation in lazyRouting mode)
+    const RoutingEngine *engine = nullptr;
+
+    // centralRouting mode: shared next-hop matrix instead of rtable
+    const RoutingDatabase *routingDatabase = nullptr;
+    const RoutingDatabase *precomputedRoutes = nullptr;  // during initialization only
+    int myNodeIndex = -1;  // index of this router in the routing engine
+    bool routesInstalled = false;  // routeDistribution = "inband": got the RouteUpdate
+    int routeUpdateSequenceNumber = 0;  // of the updates originated here
+    std::map<int, int> lastSequenceNumbers;  // origin address -> newest update processed
+    int numRouteUpdates = 0;
+    int numDuplicateRouteUpdates = 0;
+    bool ecmp = false;  // multipath forwarding, distributed mode only
+    RoutingEngine::Kernel routeKernel = RoutingEngine::PER_SOURCE;  // for the all-pairs matrix
+
+    // hierarchical routing (areaSize > 0): full routes inside the own area,
+    // one next hop per remote area
+    int areaSize = 0;
+    int myArea = -1;
+    std::vector<int16_t> areaNextHops;  // area -> gate index
+    const AreaRoutes *areaRoutes = nullptr;  // during initialization only
 
+    // adaptiveRouting: rtable entries are ordered groups of candidate next
+    // hops (shortest path first), and the lookup picks the least loaded one
+    bool adaptiveRouting = false;
+    bool rateLoadMetric = false;  // loadMetric = "rate": forwarded bytes/s instead of queue length
+    double adaptiveSlack = 0;
+    double loadEwmaWeight = 1;
+    simtime_t loadUpdateInterval;
+    simtime_t lastLoadUpdate;
+    std::vector<double> gateLoads;  // smoothed load per output gate, read by the lookup
+    std::vector<int> queueLengths;  // latest qlen signal value per output gate
+    std::vector<bool> queueBusy;    // latest busy signal value per output gate
+    std::vector<uint64_t> lastPortBytes;  // rate metric: portCounters[i].bytes at the last update
+    std::map<const cComponent *, int> queuePorts;  // queue module -> output gate index
+    simsignal_t qlenSignal;
+    simsignal_t busySignal;
+    bool fastMode = FAST_MODE_FORCED;  // no per-packet logging, bubbles
+
+    // output gates resolved at initialization, so send() takes a pointer
+    // instead of looking up the gate by name and index
+    std::vector<cGate *> outGates;
+    cGate *localOutGate = nullptr;
+    // fastDataPlane: packets with a plain next hop are forwarded by a short
+    // path in handleMessage(); everything else takes the general path
+    bool fastDataPlane = false;
+
+    // dynamicRouting mode: incrementally repaired routes, and the scripted
+    // failure events that concern this router
+    struct FailureEvent {
+        simtime_t time;
+        bool up;
+        int peerAddress;  // -1 for node events
+    };
+    DynamicRouting *dynamicRouting = nullptr;
+    std::vector<FailureEvent> failureEvents;  // sorted by time
+    size_t nextFailureEvent = 0;
+    cMessage *failureTimer = nullptr;
+
+    enum { DROP = 1 << 0, OUTPUT_IF = 1 << 1 };
+    unsigned signalMask = 0;  // signals enabled at initialization
+    // ✅ CHANGE: Always-on instrumentation counters, indexed by output gate
+    // ✔️ IMPACT: Link utilization per port at the cost of two increments per packet
+    std::vector<PortCounters> portCounters;
+    std::vector<int> portPeerAddresses;  // address of the neighbor on each port, -1 if unknown
+    PortCounters localCounters;
+    PortCounters dropCounters;
+    bool recordPortCounters = false;
+
+    // sampled timing of the route lookup: every lookupTimingInterval-th packet
+    int lookupTimingInterval = 0;
+    int lookupCountdown = 0;
+    uint64_t numLookupSamples = 0;
+    double lookupTimeSum = 0;  // nanoseconds
+    double lookupTimeMax = 0;
+
+    // statisticsMode = "aggregated"/"both": outputIf and drop summaries
+    // (taken from the counters above) recorded at finish()
+    bool aggregateStats = false;
+    // resultStreamFile: per-packet values written to the run's columnar file
+    ResultStream *resultStream = nullptr;
+    int streamSourceId = -1;
+    int dropMetricId = -1;
+    int outputIfMetricId = -1;
     simsignal_t dropSignal;
     simsignal_t outputIfSignal;
 
+    // profileRouting: startup phases, searches and memory, shared by all routers
+    RoutingProfiler *profiler = nullptr;
+
+  public:
+    virtual ~Routing();
+
   protected:
-    virtual void initialize() override;
+    virtual int numInitStages() const override { return 2; }
+    virtual void initialize(int stage) override;
     virtual void handleMessage(cMessage *msg) override;
+    virtual void finish() override;
+
+    virtual void releaseTopology();
+    virtual int addGroup(const int16_t *groupGates, int count, bool keepOrder = false);
+
+    // profileRouting
+    virtual void noteSharedMemory();
+    virtual void routesReady();
+    virtual size_t getTableMemoryUsage() const;
+
+    // dynamicRouting mode
+    virtual void parseFailureSchedule(const char *schedule);
+    virtual void processFailureEvent(const FailureEvent& event);
+    virtual void setChannelDisabled(int portIndex, bool disabled);
+    virtual void nextHopChanged(int destAddress, int gateIndex) override;
+
+    // centralRouting with routeDistribution = "inband"
+    virtual void originateRouteUpdate();
+    virtual void processRouteUpdate(RouteUpdate *update);
+    virtual void floodRouteUpdate(RouteUpdate *update, int exceptGateIndex);
+
+    // lazyRouting mode: computes and caches the next hop for one destination
+    virtual int resolveRoute(int destAddr);
+
+    // adaptiveRouting mode
+    virtual void computeAdaptiveNextHops(std::vector<int16_t>& nextHops);
+    virtual void updateGateLoads();
+    using cListener::receiveSignal;
+    virtual void receiveSignal(cComponent *source, simsignal_t signalID, intval_t value, cObject *details) override;
+    virtual void receiveSignal(cComponent *source, simsignal_t signalID, bool value, cObject *details) override;
 };
 
 Define_Module(Routing);
 
-void Routing::initialize()
+static NextHopTable::Type parseTableType(const char *s)
 {
-    myAddress = getParentModule()->par("address");
+    if (!strcmp(s, "auto"))
+        return NextHopTable::AUTO;
+    else if (!strcmp(s, "dense"))
+        return NextHopTable::DENSE;
+    else if (!strcmp(s, "sparse"))
+        return NextHopTable::SPARSE;
+    throw cRuntimeError("Invalid routingTableType '%s', must be auto, dense or sparse", s);
+}
 
-    dropSignal = registerSignal("drop");
-    outputIfSignal = registerSignal("outputIf");
+static RoutingEngine::Kernel parseKernel(const char *s)
+{
+    if (!strcmp(s, "bfs"))
+        return RoutingEngine::PER_SOURCE;
+    else if (!strcmp(s, "bitset"))
+        return RoutingEngine::BITSET_BFS;
+    throw cRuntimeError("Invalid routeComputationKernel '%s', must be bfs or bitset", s);
+}
 
-    // ✅ CHANGE 1:
-    if (par("centralRouting").boolValue()) {
-        // ✅ CHANGE 2:
-        if (myAddress == 0) {
-            EV << "Central routing node calculating paths for all nodes...\n";
+static inline uint32_t flowHash(int srcAddr, int destAddr)
+{
+    // multiplicative hash, so that consecutive addresses spread over the group
+    uint32_t h = (uint32_t)srcAddr * 2654435761u ^ (uint32_t)destAddr * 2246822519u;
+    return h ^ (h >> 15);
+}
+
+Routing::~Routing()
+{
+    if (routingDatabase)
+        RoutingDatabase::release();
+    if (precomputedRoutes)
+        RoutingDatabase::release();
+    if (dynamicRouting) {
+        dynamicRouting->setListener(myNodeIndex, nullptr);
+        DynamicRouting::release();
+    }
+    cancelAndDelete(failureTimer);
+    if (resultStream)
+        ResultStream::release();
+    if (areaRoutes)
+        AreaRoutes::release();
+    if (!queuePorts.empty()) {
+        getParentModule()->unsubscribe(qlenSignal, this);
+        getParentModule()->unsubscribe(busySignal, this);
+    }
+    releaseTopology();
+    if (profiler)
+        RoutingProfiler::release();
+}
+
+void Routing::releaseTopology()
+{
+    if (engine) {
+        if (profiler)
+            profiler->noteEngine(engine);
+        TopologyCache::release(engine);
+        engine = nullptr;
+    }
+}
+
+int Routing::addGroup(const int16_t *groupGates, int count, bool keepOrder)
+{
+    // NextHopTable does not use the kernel; report its overflow with the module
+    try {
+        return rtable.addGroup(groupGates, count, keepOrder);
+    }
+    catch (std::length_error& e) {
+        throw cRuntimeError("%s", e.what());
+    }
+}
 
-            cTopology *topo = new cTopology("topo");
+void Routing::noteSharedMemory()
+{
+    // the structures shared by the routers that are alive at this point
+    size_t bytes = engine ? engine->getMemoryUsage() : 0;
+    if (routingDatabase)
+        bytes += routingDatabase->getMemoryUsage();
+    if (precomputedRoutes)
+        bytes += precomputedRoutes->getMemoryUsage();
+    profiler->noteSharedMemory(bytes);
+}
 
-            std::vector<std::string> nedTypes;
-            nedTypes.push_back(getParentModule()->getNedTypeName());
-            topo->extractByNedTypeName(nedTypes);
-            EV << "cTopology found " << topo->getNumNodes() << " nodes\n";
+size_t Routing::getTableMemoryUsage() const
+{
+    return rtable.getMemoryUsage() + areaNextHops.capacity() * sizeof(int16_t);
+}
 
-            cTopology::Node *thisNode = topo->getNodeFor(getParentModule());
+void Routing::routesReady()
+{
+    // the last router of the partition to get its routes prints the summary,
+    // so it is there even when the run is stopped before finish(); stdout
+    // rather than EV, which Cmdenv express mode (batch runs) suppresses
+    if (!profiler->routerReady(getTableMemoryUsage()))
+        return;
+    if (engine)
+        profiler->noteEngine(engine);
+    std::cout << profiler->getSummary() << std::endl;
+    profiler->setReported();
+}
 
-            // ✅ CHANGE 3:
-            cMessage *routeMsg = new cMessage("ROUTE_UPDATE");
+void Routing::initialize(int stage)
+{
+    if (stage == 0) {
+        myAddress = getParentModule()->par("address");
+        fastMode = FAST_MODE_FORCED || par("fastMode").boolValue();
 
-            // ✅ CHANGE 4:
-            cMsgPar *routingInfo = new cMsgPar("routingInfo");
-            std::string routes;
+        dropSignal = registerSignal("drop");
+        outputIfSignal = registerSignal("outputIf");
+        static const char *const signalNames[] = { "drop", "outputIf" };
+        const char *statisticsMode = par("statisticsMode").stringValue();
+        bool collect = par("collectStatistics").boolValue();
+        aggregateStats = collect && strcmp(statisticsMode, "signals") != 0;
+        if (strcmp(statisticsMode, "aggregated") == 0)
+            collect = false;
+        signalMask = resolveSignalMask(collect, par("enabledSignals").stringValue(), signalNames, 2);
 
-            for (int i = 0; i < topo->getNumNodes(); i++) {
-                if (topo->getNode(i) == thisNode)
-                    continue;
+        int numOutGates = gateSize("out");
+        if (par("profileRouting").boolValue())
+            profiler = RoutingProfiler::acquire();
 
-                topo->calculateUnweightedSingleShortestPathsTo(topo->getNode(i));
+        outGates.resize(numOutGates);
+        for (int i = 0; i < numOutGates; i++)
+            outGates[i] = gate("out", i);
+        localOutGate = gate("localOut");
 
-                if (thisNode->getNumPaths() == 0)
-                    continue;
+        // ✅ CHANGE: Fast data plane -- per-hop work is a kind check, a table
+        // index and a send on a cached gate pointer
+        // ✔️ IMPACT: No cast check, no signal code and no gate lookup by name
+        // on the hops of large runs
+        fastDataPlane = par("fastDataPlane").boolValue();
+        if (fastDataPlane && (signalMask || *par("resultStreamFile").stringValue() || par("lookupTimingInterval").intValue() > 0))
+            throw cRuntimeError("fastDataPlane requires that no per-packet signals or values are recorded (use statisticsMode = \"aggregated\", and no resultStreamFile or lookupTimingInterval)");
 
-                cGate *parentModuleGate = thisNode->getPath(0)->getLocalGate();
-                int gateIndex = parentModuleGate->getIndex();
-                int destAddress = topo->getNode(i)->getModule()->par("address");
+        portCounters.assign(gateSize("out"), PortCounters());
+        portPeerAddresses.assign(gateSize("out"), -1);
+        recordPortCounters = par("recordPortCounters").boolValue();
+        lookupTimingInterval = par("lookupTimingInterval").intValue();
+        lookupCountdown = lookupTimingInterval;
+        WATCH_VECTOR(portCounters);
+        WATCH(localCounters);
+        WATCH(dropCounters);
+        WATCH(numRouteUpdates);
+        WATCH(numDuplicateRouteUpdates);
+        const char *resultStreamFile = par("resultStreamFile").stringValue();
+        if (par("collectStatistics").boolValue() && *resultStreamFile) {
+            resultStream = ResultStream::acquire(resultStreamFile);
+            streamSourceId = resultStream->addSource(getFullPath().c_str());
+            dropMetricId = resultStream->getMetricId("drop");
+            outputIfMetricId = resultStream->getMetricId("outputIf");
+        }
 
-                if (!routes.empty()) routes += ",";
-                routes += std::to_string(destAddress) + ":" + std::to_string(gateIndex);
+        // ✅ CHANGE: The topology is extracted once per network and shared by
+        // all routers; every router holds a reference until stage 1 is done
+        // ✔️ IMPACT: One extraction instead of one per router, and the graph
+        // is freed as soon as the last router has computed its routes
+        // ✅ CHANGE: Under parallel simulation, a partition only has its own
+        // modules, so the graph comes from a topology file instead
+        // ✔️ IMPACT: Every partition computes the same routes without touching remote modules
+        const char *topologyFile = par("topologyFile").stringValue();
+        bool parallel = getEnvir()->getParsimNumPartitions() > 1;
+        if (parallel && !*topologyFile)
+            throw cRuntimeError("Parallel simulation requires a topologyFile (write one with topologyExportFile in a sequential run)");
+        if (parallel && (par("dynamicRouting").boolValue() || par("failureSchedule").stdstringValue() != "" ||
+                         (par("centralRouting").boolValue() && !strcmp(par("routeDistribution").stringValue(), "inband"))))
+            throw cRuntimeError("dynamicRouting, failureSchedule and inband routeDistribution are not supported under parallel simulation");
+        {
+            RoutingProfiler::Timer timer(profiler, RoutingProfiler::EXTRACT);
+            if (*topologyFile)
+                engine = TopologyCache::acquireFromFile(getParentModule(), topologyFile);
+            else {
+                TopologyCache::LinkMetric metric = TopologyCache::parseLinkMetric(par("routingMetric").stringValue());
+                engine = TopologyCache::acquire(getParentModule(), metric, par("metricPacketLength").intValue());
             }
+        }
+        myNodeIndex = engine->getNodeIndex(myAddress);
+        if (myNodeIndex == -1)
+            throw cRuntimeError("Address %d not found in the extracted topology", myAddress);
+        const char *topologyExportFile = par("topologyExportFile").stringValue();
+        if (*topologyExportFile && myNodeIndex == 0)
+            TopologyCache::exportTopology(engine, topologyExportFile);
 
-            routingInfo->setStringValue(routes.c_str());
-            routeMsg->addPar(routingInfo);
-
-            // ✅ CHANGE 5: Broadcast the routing message to all nodes
-            // ✔️ IMPACT: Shares computed data without extra CPU/memory cost
-            for (int i = 0; i < gateSize("out"); i++) {
-                send(routeMsg->dup(), "out", i);
+        // ✅ CHANGE: With multiple threads, the routes of all routers are
+        // computed in parallel into a shared matrix, before any router
+        // reads it in stage 1
+        // ✔️ IMPACT: Startup time of large meshes scales with the core count
+        ecmp = par("ecmp");
+        routeKernel = parseKernel(par("routeComputationKernel").stringValue());
+        bool dynamic = par("dynamicRouting").boolValue() || par("failureSchedule").stdstringValue() != "";
+        areaSize = par("areaSize");
+        adaptiveRouting = par("adaptiveRouting");
+        if (profiler) {
+            bool central = par("centralRouting").boolValue();
+            const char *mode = central ? (!strcmp(par("routeDistribution").stringValue(), "inband") ? "central-inband" : "central")
+                               : par("lazyRouting").boolValue() ? "lazy" : adaptiveRouting ? "adaptive" : areaSize > 0 ? "hierarchical"
+                               : dynamic ? "dynamic" : ecmp ? "ecmp" : "distributed";
+            profiler->setMode(mode, par("routeComputationKernel").stringValue());
+        }
+        if (adaptiveRouting) {
+            if (dynamic || ecmp || areaSize > 0 || par("centralRouting").boolValue() || par("lazyRouting").boolValue())
+                throw cRuntimeError("adaptiveRouting requires plain distributed routing (no centralRouting, lazyRouting, ecmp, dynamicRouting or areaSize)");
+            rateLoadMetric = !strcmp(par("loadMetric").stringValue(), "rate");
+            adaptiveSlack = par("adaptiveSlack");
+            loadEwmaWeight = par("loadEwmaWeight");
+            if (loadEwmaWeight <= 0 || loadEwmaWeight > 1)
+                throw cRuntimeError("loadEwmaWeight must be in (0,1]");
+            loadUpdateInterval = par("loadUpdateInterval").doubleValue();
+            int numPorts = gateSize("out");
+            gateLoads.assign(numPorts, 0);
+            queueLengths.assign(numPorts, 0);
+            queueBusy.assign(numPorts, false);
+            lastPortBytes.assign(numPorts, 0);
+            WATCH_VECTOR(gateLoads);
+            if (!rateLoadMetric) {
+                // the queues emit qlen/busy, which propagate up to the node
+                for (int i = 0; i < numPorts; i++) {
+                    cGate *queueGate = gate("out", i)->getNextGate();
+                    if (queueGate)
+                        queuePorts[queueGate->getOwnerModule()] = i;
+                }
+                qlenSignal = registerSignal("qlen");
+                busySignal = registerSignal("busy");
+                getParentModule()->subscribe(qlenSignal, this);
+                getParentModule()->subscribe(busySignal, this);
             }
+            return;
+        }
+        if (ecmp && (par("centralRouting").boolValue() || par("lazyRouting").boolValue()))
+            throw cRuntimeError("ecmp requires distributed routing (no centralRouting or lazyRouting)");
+        if (areaSize > 0) {
+            if (dynamic || ecmp || par("centralRouting").boolValue() || par("lazyRouting").boolValue())
+                throw cRuntimeError("areaSize > 0 (hierarchical routing) requires plain distributed routing (no centralRouting, lazyRouting, ecmp or dynamicRouting)");
+            if (myAddress < 0)
+                throw cRuntimeError("Hierarchical routing requires non-negative addresses");
+            myArea = myAddress / areaSize;
+            RoutingProfiler::Timer timer(profiler, RoutingProfiler::COMPUTE);
+            areaRoutes = AreaRoutes::acquire(engine, areaSize);
+            return;
+        }
+        if (dynamic && (ecmp || par("centralRouting").boolValue() || par("lazyRouting").boolValue()))
+            throw cRuntimeError("dynamicRouting / failureSchedule requires plain distributed routing (no centralRouting, lazyRouting or ecmp)");
+        if (dynamic) {
+            RoutingProfiler::Timer timer(profiler, RoutingProfiler::COMPUTE);
+            dynamicRouting = DynamicRouting::acquire(engine);
+            parseFailureSchedule(par("failureSchedule").stringValue());
+            return;
+        }
 
-            delete routeMsg;
-            delete topo;
+        // ✅ CHANGE: The matrix can also come from a route snapshot file
+        // saved by an earlier run on the same topology
+        // ✔️ IMPACT: Repeated runs of a sweep replace route computation by an mmap and a checksum
+        // ✅ CHANGE: The bitset kernel computes batches of destination
+        // columns, so it always goes through the shared matrix
+        // ✔️ IMPACT: 256 BFS trees per pass with word-wide operations per link
+        int numThreads = par("routeComputationThreads");
+        const char *snapshotFile = par("routeSnapshotFile").stringValue();
+        bool precompute = numThreads != 1 || *snapshotFile || routeKernel != RoutingEngine::PER_SOURCE;
+        if (precompute && !ecmp && !par("centralRouting").boolValue() && !par("lazyRouting").boolValue()) {
+            RoutingProfiler::Timer timer(profiler, RoutingProfiler::COMPUTE);
+            precomputedRoutes = RoutingDatabase::acquire(engine, numThreads, snapshotFile, routeKernel);
+            if (myNodeIndex == 0 && *snapshotFile)
+                EV << precomputedRoutes->getSnapshotStatus() << endl;
         }
+        return;
+    }
+
+    for (int e = engine->getLinkBegin(myNodeIndex); e < engine->getLinkEnd(myNodeIndex); e++)
+        portPeerAddresses[engine->getLinkGate(e)] = engine->getAddress(engine->getLinkTarget(e));
+    if (profiler)
+        noteSharedMemory();
+    bool inband = par("centralRouting").boolValue() && !strcmp(par("routeDistribution").stringValue(), "inband");
+
+    // ✅ CHANGE 1:
+    if (inband) {
+        // ✅ CHANGE: In-band distribution -- the origin node floods the whole
+        // next-hop matrix in one RouteUpdate with a packed binary payload,
+        // shared by reference between all copies of the message
+        // ✔️ IMPACT: No string building and no per-link copies of the routes
+        if (myAddress == par("routeOriginAddress").intValue())
+            originateRouteUpdate();
+        releaseTopology();
+    }
+    else if (par("centralRouting").boolValue()) {
+        // ✅ CHANGE 2: All routers share one central routing database that
+        // holds the full next-hop matrix, computed once for the whole network.
+        // ✔️ IMPACT: No per-node tables and no route messages; each router
+        // reads its own row of the matrix in place.
+        {
+            RoutingProfiler::Timer timer(profiler, RoutingProfiler::COMPUTE);
+            routingDatabase = RoutingDatabase::acquire(engine, par("routeComputationThreads"), par("routeSnapshotFile").stringValue(), routeKernel);
+        }
+        if (profiler)
+            noteSharedMemory();
+        if (myNodeIndex == 0 && !routingDatabase->getSnapshotStatus().empty())
+            EV << routingDatabase->getSnapshotStatus() << endl;
+        EV << "Central routing database holds routes for " << routingDatabase->getNumNodes() << " nodes\n";
+        releaseTopology();
+    }
+    else if (par("lazyRouting").boolValue()) {
+        // ✅ CHANGE: On-demand route calculation -- the next hop towards a
+        // destination is computed when the first packet for it arrives
+        // ✔️ IMPACT: Startup cost is proportional to the number of
+        // destinations actually used, not to the network size
+        EV << "Lazy routing - paths are calculated on demand\n";
+
+        RoutingProfiler::Timer timer(profiler, RoutingProfiler::TABLE_FILL);
+        std::vector<std::pair<int, int>> entries;
+        for (int i = 0; i < engine->getNumNodes(); i++)
+            if (i != myNodeIndex)
+                entries.push_back(std::make_pair(engine->getAddress(i), (int)NextHopTable::UNKNOWN));
+        rtable.build(entries, parseTableType(par("routingTableType").stringValue()));
+    }
+    else if (areaRoutes) {
+        // ✅ CHANGE: Hierarchical routing -- routes on paths inside the own
+        // area, plus one next hop per remote area towards its nearest member
+        // ✔️ IMPACT: Routing state per router is about areaSize + N/areaSize
+        // entries instead of N, while paths stay loop-free
+        EV << "Hierarchical routing - area " << myArea << " of " << areaRoutes->getNumAreas() << "\n";
+        // ✅ CHANGE: The search inside the area only touches the members of
+        // the area, and returns one entry per member
+        // ✔️ IMPACT: O(areaSize) work per router instead of O(N), so
+        // startup stays O(N * areaSize) in total
+        const int *members = areaRoutes->getAreaMembers(myArea);
+        int numMembers = areaRoutes->getNumAreaMembers(myArea);
+        std::vector<int16_t> nextHops;  // indexed like members
+        {
+            RoutingProfiler::Timer timer(profiler, RoutingProfiler::COMPUTE);
+            engine->computeNextHopsWithin(myNodeIndex, members, numMembers, areaRoutes->getLocalIndices().data(), nextHops);
+        }
+        RoutingProfiler::Timer timer(profiler, RoutingProfiler::TABLE_FILL);
+        std::vector<std::pair<int, int>> entries;
+        for (int k = 0; k < numMembers; k++) {
+            if (members[k] == myNodeIndex)
+                continue;
+            if (nextHops[k] == RoutingEngine::NO_ROUTE)
+                EV_WARN << "address " << engine->getAddress(members[k]) << " is in my area, but not reachable inside it\n";
+            else
+                entries.push_back(std::make_pair(engine->getAddress(members[k]), (int)nextHops[k]));
+        }
+        rtable.build(entries, parseTableType(par("routingTableType").stringValue()));
+
+        areaNextHops.resize(areaRoutes->getNumAreas());
+        for (int area = 0; area < areaRoutes->getNumAreas(); area++)
+            areaNextHops[area] = area == myArea ? RoutingEngine::NO_ROUTE : areaRoutes->getNextHopToArea(myNodeIndex, area);
+        EV << "Routing table has " << rtable.getNumEntries() << " entries in the area, and "
+           << areaNextHops.size() << " area routes\n";
+
+        AreaRoutes::release();
+        areaRoutes = nullptr;
+        releaseTopology();
     }
     else {
         // ✅ RETAINED: Distributed routing logic from original implementation
         // ✔️ IMPACT: Fallback mode for experiments, maintains compatibility
         EV << "Distributed routing - calculating paths independently...\n";
 
-        cTopology *topo = new cTopology("topo");
+        // ✅ CHANGE: A single BFS from this node over the shared topology
+        // yields all next hops.
+        // ✔️ IMPACT: O(E) per router instead of one traversal per destination
+        std::vector<int16_t> nextHops;
+        {
+            RoutingProfiler::Timer timer(profiler, RoutingProfiler::COMPUTE);
+            if (adaptiveRouting) {
+                // ✅ CHANGE: Keep the loop-free next hops within the cost slack;
+                // every packet takes the least loaded one
+                // ✔️ IMPACT: Traffic moves off congested ports onto idle
+                // alternatives, at the cost of one search per neighbor here
+                computeAdaptiveNextHops(nextHops);
+            }
+            else if (ecmp) {
+                // ✅ CHANGE: Keep all equal-cost next hops; packets of a flow are
+                // mapped to one of them by hashing (srcAddr, destAddr)
+                // ✔️ IMPACT: Parallel shortest paths share the load, while the
+                // packets of one flow stay in order
+                static_assert(RoutingEngine::MAX_PATHS <= NextHopTable::MAX_GROUP_SIZE, "equal-cost path sets must fit in a group without truncation");
+                std::vector<RoutingEngine::PathSet> paths;
+                engine->computeMultiPathsFrom(myNodeIndex, paths);
+                nextHops.resize(paths.size());
+                for (size_t i = 0; i < paths.size(); i++)
+                    nextHops[i] = addGroup(paths[i].gates, paths[i].count);
+            }
+            else if (dynamicRouting) {
+                const int16_t *row = dynamicRouting->getRow(myNodeIndex);
+                nextHops.assign(row, row + engine->getNumNodes());
+                dynamicRouting->setListener(myNodeIndex, this);
+            }
+            else if (!precomputedRoutes)
+                engine->computeNextHopsFrom(myNodeIndex, nextHops);
+            else {
+                // pick up our row of the matrix precomputed in stage 0; the matrix
+                // is freed when the last router has released it
+                const int16_t *row = precomputedRoutes->getRow(myNodeIndex);
+                nextHops.assign(row, row + precomputedRoutes->getNumNodes());
+                RoutingDatabase::release();
+                precomputedRoutes = nullptr;
+            }
+        }
 
-        std::vector<std::string> nedTypes;
-        nedTypes.push_back(getParentModule()->getNedTypeName());
-        topo->extractByNedTypeName(nedTypes);
-        EV << "cTopology found " << topo->getNumNodes() << " nodes\n";
+        RoutingProfiler::Timer timer(profiler, RoutingProfiler::TABLE_FILL);
+        std::vector<std::pair<int, int>> entries;
+        for (int i = 0; i < engine->getNumNodes(); i++) {
+            if (i == myNodeIndex)
+                continue;
+            if (nextHops[i] == RoutingEngine::NO_ROUTE && !dynamicRouting)
+                continue;  // not connected (dynamic routing keeps an entry to patch later)
 
-        cTopology::Node *thisNode = topo->getNodeFor(getParentModule());
+            int gateIndex = nextHops[i];
+            int address = engine->getAddress(i);
+            entries.push_back(std::make_pair(address, gateIndex));
+            if (gateIndex >= 0)
+                EV << "  towards address " << address << " gateIndex is " << gateIndex << endl;
+            else
+                EV << "  towards address " << address << " using multipath group " << gateIndex << endl;
+        }
+        rtable.build(entries, parseTableType(par("routingTableType").stringValue()));
+        EV << "Routing table has " << rtable.getNumEntries() << " entries, "
+           << (rtable.isDense() ? "dense" : "sparse") << " layout, "
+           << rtable.getNumGroups() << " multipath groups\n";
+        if (!dynamicRouting)
+            releaseTopology();  // dynamic routing needs the topology until the end
+    }
 
-        for (int i = 0; i < topo->getNumNodes(); i++) {
-            if (topo->getNode(i) == thisNode)
-                continue;
+    if (profiler && !inband)
+        routesReady();  // inband: when the RouteUpdate arrives
+}
 
-            topo->calculateUnweightedSingleShortestPathsTo(topo->getNode(i));
+void Routing::parseFailureSchedule(const char *schedule)
+{
+    // entries are separated by ';', each is "<time> linkdown|linkup <addr> <addr>"
+    // or "<time> nodedown|nodeup <addr>"; a router executes the entries with
+    // its own address first
+    auto parseAddress = [](const std::string& token) {
+        size_t end = 0;
+        int address = -1;
+        try {
+            address = std::stoi(token, &end);
+        }
+        catch (std::exception&) {
+            end = 0;  // not a number, or out of range
+        }
+        if (end == 0 || end != token.size())
+            throw cRuntimeError("failureSchedule: invalid address '%s'", token.c_str());
+        return address;
+    };
 
-            if (thisNode->getNumPaths() == 0)
-                continue;
+    cStringTokenizer entryTokenizer(schedule, ";");
+    while (entryTokenizer.hasMoreTokens()) {
+        std::vector<std::string> tokens = cStringTokenizer(entryTokenizer.nextToken()).asVector();
+        if (tokens.empty())
+            continue;
+        const std::string& type = tokens.size() >= 2 ? tokens[1] : "";
+        bool isLink = (type == "linkdown" || type == "linkup");
+        bool isNode = (type == "nodedown" || type == "nodeup");
+        if ((!isLink && !isNode) || tokens.size() != (isLink ? 4u : 3u))
+            throw cRuntimeError("Invalid failureSchedule entry '%s %s...'", tokens[0].c_str(), type.c_str());
+        if (parseAddress(tokens[2]) != myAddress)
+            continue;
 
-            cGate *parentModuleGate = thisNode->getPath(0)->getLocalGate();
-            int gateIndex = parentModuleGate->getIndex();
-            int address = topo->getNode(i)->getModule()->par("address");
-            rtable[address] = gateIndex;
-            EV << "  towards address " << address << " gateIndex is " << gateIndex << endl;
+        FailureEvent event;
+        event.time = SimTime::parse(tokens[0].c_str());
+        event.up = (type == "linkup" || type == "nodeup");
+        event.peerAddress = isLink ? parseAddress(tokens[3]) : -1;
+        if (isLink && engine->getNodeIndex(event.peerAddress) == -1)
+            throw cRuntimeError("failureSchedule: unknown address %d", event.peerAddress);
+        failureEvents.push_back(event);
+    }
+    std::stable_sort(failureEvents.begin(), failureEvents.end(),
+            [](const FailureEvent& a, const FailureEvent& b) { return a.time < b.time; });
+
+    if (!failureEvents.empty()) {
+        failureTimer = new cMessage("failureTimer", ROUTING_CONTROL);  // dispatched with the control messages
+        scheduleAt(failureEvents[0].time, failureTimer);
+    }
+}
+
+void Routing::setChannelDisabled(int portIndex, bool disabled)
+{
+    // Disable both directions of the link attached to the given port. The
+    // link starts at the output gate of the node with the port index (the
+    // local gate of the extracted topology) that leads out of the node; the
+    // way back is found by following the connections, so neither the gate
+    // names nor the port index at the peer are assumed.
+    cModule *node = getParentModule();
+    cGate *outGate = nullptr;
+    for (cModule::GateIterator it(node); !it.end() && !outGate; ++it) {
+        cGate *gate = *it;
+        cGate *next = gate->getType() == cGate::OUTPUT && gate->getIndex() == portIndex ? gate->getNextGate() : nullptr;
+        if (next && next->getOwnerModule() != node && !node->containsModule(next->getOwnerModule()))
+            outGate = gate;
+    }
+    if (!outGate)
+        throw cRuntimeError("No link found on port %d", portIndex);
+
+    cGate *remoteInGate = outGate->getNextGate();
+    cModule *remoteNode = remoteInGate->getOwnerModule();
+    cGate *remoteOutGate = remoteInGate->getOtherHalf();  // duplex (inout) link
+    for (cModule::GateIterator it(remoteNode); !it.end() && !remoteOutGate; ++it) {
+        cGate *gate = *it;  // separate input and output gates: the output connected back to us
+        if (gate->getType() == cGate::OUTPUT && gate->getNextGate() && gate->getNextGate()->getOwnerModule() == node)
+            remoteOutGate = gate;
+    }
+
+    for (cGate *gate : {outGate, remoteOutGate})
+        if (gate)
+            if (cDatarateChannel *channel = dynamic_cast<cDatarateChannel *>(gate->getChannel()))
+                channel->setDisabled(disabled);
+}
+
+void Routing::processFailureEvent(const FailureEvent& event)
+{
+    // ✅ CHANGE: Failures only repair the shortest path trees that use the
+    // failed element, and patch the affected routing table entries in place
+    // ✔️ IMPACT: No full route recomputation in every router on each event
+    if (event.peerAddress == -1) {
+        EV << "node " << (event.up ? "up" : "down") << endl;
+        if (!fastMode)
+            bubble(event.up ? "node up" : "node down");
+        for (int e = engine->getLinkBegin(myNodeIndex); e < engine->getLinkEnd(myNodeIndex); e++)
+            setChannelDisabled(engine->getLinkGate(e), !event.up);
+        dynamicRouting->setNodeState(myNodeIndex, event.up);
+    }
+    else {
+        EV << "link to address " << event.peerAddress << (event.up ? " up" : " down") << endl;
+        if (!fastMode)
+            bubble(event.up ? "link up" : "link down");
+        int peerNode = engine->getNodeIndex(event.peerAddress);
+        for (int e = engine->getLinkBegin(myNodeIndex); e < engine->getLinkEnd(myNodeIndex); e++)
+            if (engine->getLinkTarget(e) == peerNode)
+                setChannelDisabled(engine->getLinkGate(e), !event.up);
+        dynamicRouting->setLinkState(myNodeIndex, peerNode, event.up);
+        dynamicRouting->setLinkState(peerNode, myNodeIndex, event.up);
+    }
+    EV << "dynamic routing: " << dynamicRouting->getNumTreesRepaired() << " trees repaired, "
+       << dynamicRouting->getNumNodesUpdated() << " next hops updated so far\n";
+}
+
+void Routing::nextHopChanged(int destAddress, int gateIndex)
+{
+    rtable.set(destAddress, gateIndex);
+}
+
+void Routing::originateRouteUpdate()
+{
+    EV << "Central routing node calculating paths for all nodes...\n";
+    int numNodes = engine->getNumNodes();
+    std::vector<int16_t> nextHops((size_t)numNodes * numNodes);
+    {
+        RoutingProfiler::Timer timer(profiler, RoutingProfiler::COMPUTE);
+        engine->computeAllNextHops(nextHops.data(), par("routeComputationThreads"), routeKernel);
+    }
+    if (profiler)
+        profiler->noteSharedMemory(engine->getMemoryUsage() + nextHops.capacity() * sizeof(int16_t));
+    std::vector<int> addresses;
+    for (int i = 0; i < numNodes; i++)
+        addresses.push_back(engine->getAddress(i));
+
+    RouteUpdate *update = new RouteUpdate("ROUTE_UPDATE");
+    update->setOriginAddress(myAddress);
+    update->setSequenceNumber(++routeUpdateSequenceNumber);
+    {
+        RoutingProfiler::Timer timer(profiler, RoutingProfiler::DISSEMINATION);
+        update->setPayload(RoutePayload::encode(addresses, nextHops.data()));
+        update->setByteLength(update->getPayload()->getByteSize());
+    }
+    processRouteUpdate(update);
+}
+
+void Routing::processRouteUpdate(RouteUpdate *update)
+{
+    // ✅ CHANGE: Flooded updates are processed once per sequence number
+    // ✔️ IMPACT: Copies arriving over other paths are dropped instead of re-sent
+    auto it = lastSequenceNumbers.find(update->getOriginAddress());
+    if (it != lastSequenceNumbers.end() && update->getSequenceNumber() <= it->second) {
+        numDuplicateRouteUpdates++;
+        delete update;
+        return;
+    }
+    lastSequenceNumbers[update->getOriginAddress()] = update->getSequenceNumber();
+    numRouteUpdates++;
+
+    const RoutePayload *payload = update->getPayload().get();
+    int myIndex = payload->findNode(myAddress);
+    if (myIndex == -1)
+        throw cRuntimeError("Address %d not found in RouteUpdate from %d", myAddress, update->getOriginAddress());
+    std::vector<std::pair<int, int>> entries;
+    {
+        RoutingProfiler::Timer timer(profiler, RoutingProfiler::DISSEMINATION);
+        payload->decodeRow(myIndex, entries);
+    }
+    {
+        RoutingProfiler::Timer timer(profiler, RoutingProfiler::TABLE_FILL);
+        rtable.build(entries, parseTableType(par("routingTableType").stringValue()));
+    }
+    bool firstInstall = !routesInstalled;
+    routesInstalled = true;
+    EV << "Installed " << entries.size() << " routes from node " << update->getOriginAddress()
+       << ", update #" << update->getSequenceNumber() << endl;
+
+    {
+        RoutingProfiler::Timer timer(profiler, RoutingProfiler::DISSEMINATION);
+        floodRouteUpdate(update, update->getArrivalGate() ? update->getArrivalGate()->getIndex() : -1);
+    }
+    if (profiler && firstInstall)
+        routesReady();
+}
+
+void Routing::floodRouteUpdate(RouteUpdate *update, int exceptGateIndex)
+{
+    // in[k] and out[k] belong to the same port, so the update is not sent
+    // back where it came from
+    for (int i = 0; i < (int)outGates.size(); i++)
+        if (i != exceptGateIndex)
+            send(update->dup(), outGates[i]);
+    delete update;
+}
+
+void Routing::computeAdaptiveNextHops(std::vector<int16_t>& nextHops)
+{
+    // Candidates towards a destination are the neighbors that are strictly
+    // closer to it than this router, so every hop decreases the remaining
+    // cost and packets cannot loop whatever the loads are. Among those, the
+    // ones within adaptiveSlack of the shortest path are kept, cheapest
+    // first; with the hop count metric these are the equal-cost next hops.
+    int numNodes = engine->getNumNodes();
+    std::vector<int16_t> shortest;
+    engine->computeNextHopsFrom(myNodeIndex, shortest);
+    std::vector<double> myDist;
+    engine->computeDistancesFrom(myNodeIndex, myDist);
+    int linkBegin = engine->getLinkBegin(myNodeIndex);
+    int numLinks = engine->getLinkEnd(myNodeIndex) - linkBegin;
+    std::vector<std::vector<double>> neighborDist(numLinks);
+    for (int k = 0; k < numLinks; k++)
+        engine->computeDistancesFrom(engine->getLinkTarget(linkBegin + k), neighborDist[k]);
+
+    nextHops.assign(numNodes, RoutingEngine::NO_ROUTE);
+    std::vector<std::pair<double, int16_t>> candidates;  // path cost, gate index
+    int numAlternatives = 0;
+    for (int dest = 0; dest < numNodes; dest++) {
+        if (dest == myNodeIndex || shortest[dest] == RoutingEngine::NO_ROUTE)
+            continue;
+        candidates.clear();
+        for (int k = 0; k < numLinks; k++) {
+            int16_t gateIndex = engine->getLinkGate(linkBegin + k);
+            double cost = engine->getLinkWeight(linkBegin + k) + neighborDist[k][dest];
+            if (gateIndex != shortest[dest] && neighborDist[k][dest] < myDist[dest] && cost <= myDist[dest] + adaptiveSlack)
+                candidates.push_back(std::make_pair(cost, gateIndex));
         }
-        delete topo;
+        std::stable_sort(candidates.begin(), candidates.end());
+
+        int16_t groupGates[NextHopTable::MAX_GROUP_SIZE];
+        int count = 0;
+        groupGates[count++] = shortest[dest];
+        for (size_t i = 0; i < candidates.size() && count < NextHopTable::MAX_GROUP_SIZE; i++)
+            groupGates[count++] = candidates[i].second;
+        numAlternatives += count - 1;
+        nextHops[dest] = addGroup(groupGates, count, true);
     }
+    EV << "Adaptive routing - " << numAlternatives << " alternative next hops in total\n";
+}
+
+void Routing::updateGateLoads()
+{
+    simtime_t now = simTime();
+    double elapsed = (now - lastLoadUpdate).dbl();
+    if (rateLoadMetric && elapsed <= 0)
+        return;
+    for (size_t i = 0; i < gateLoads.size(); i++) {
+        double sample;
+        if (rateLoadMetric) {
+            sample = (portCounters[i].bytes - lastPortBytes[i]) / elapsed;
+            lastPortBytes[i] = portCounters[i].bytes;
+        }
+        else
+            sample = queueLengths[i] + (queueBusy[i] ? 1 : 0);
+        gateLoads[i] += loadEwmaWeight * (sample - gateLoads[i]);
+    }
+    lastLoadUpdate = now;
+}
+
+void Routing::receiveSignal(cComponent *source, simsignal_t signalID, intval_t value, cObject *)
+{
+    auto it = queuePorts.find(source);
+    if (it != queuePorts.end() && signalID == qlenSignal)
+        queueLengths[it->second] = (int)value;
+}
+
+void Routing::receiveSignal(cComponent *source, simsignal_t signalID, bool value, cObject *)
+{
+    auto it = queuePorts.find(source);
+    if (it != queuePorts.end() && signalID == busySignal)
+        queueBusy[it->second] = value;
+}
+
+int Routing::resolveRoute(int destAddr)
+{
+    // next hops towards a destination are shared by all routers via the
+    // engine, so each destination costs one reverse BFS for the whole network
+    int destNode = engine->getNodeIndex(destAddr);
+    int gateIndex = engine->computeNextHopsTo(destNode)[myNodeIndex];
+    rtable.set(destAddr, gateIndex);
+    EV << "  towards address " << destAddr << " gateIndex is " << gateIndex << " (computed on demand)\n";
+    return gateIndex;
 }
 
 void Routing::handleMessage(cMessage *msg)
 {
+    // ✅ CHANGE: Control messages are recognized by their kind
+    // ✔️ IMPACT: One integer compare on the data path instead of a dynamic_cast
+    if (msg->getKind() == ROUTING_CONTROL) {
+        if (msg == failureTimer) {
+            processFailureEvent(failureEvents[nextFailureEvent++]);
+            if (nextFailureEvent < failureEvents.size())
+                scheduleAt(failureEvents[nextFailureEvent].time, failureTimer);
+        }
+        else
+            processRouteUpdate(check_and_cast<RouteUpdate *>(msg));
+        return;
+    }
+
+    if (fastDataPlane) {
+        // everything that is not a control message is a Packet here; local
+        // delivery, drops, lazily resolved and multipath entries (negative
+        // table values), and remote areas continue on the general path
+        ASSERT(dynamic_cast<Packet *>(msg) != nullptr);
+        Packet *pk = static_cast<Packet *>(msg);
+        int destAddr = pk->getDestAddr();
+        int outGateIndex = routingDatabase ? routingDatabase->getNextHop(myNodeIndex, destAddr) : rtable.lookup(destAddr);
+        if (outGateIndex >= 0 && destAddr != myAddress) {
+            pk->setHopCount(pk->getHopCount() + 1);
+            portCounters[outGateIndex].count(pk->getByteLength());
+            send(pk, outGates[outGateIndex]);
+            return;
+        }
+    }
+
     Packet *pk = check_and_cast<Packet *>(msg);
     int destAddr = pk->getDestAddr();
 
     if (destAddr == myAddress) {
-        EV << "local delivery of packet " << pk->getName() << endl;
-        send(pk, "localOut"); // deliver locally
-        emit(outputIfSignal, -1);  // -1: local
+        HOT_EV << "local delivery of packet " << pk->getName() << endl;
+        localCounters.count(pk->getByteLength());
+        send(pk, localOutGate); // deliver locally
+        if (resultStream)
+            resultStream->record(simTime().dbl(), streamSourceId, outputIfMetricId, -1);
+        if ((signalMask & OUTPUT_IF) && mayHaveListeners(outputIfSignal))
+            emit(outputIfSignal, -1);  // -1: local
         return;
     }
 
-    RoutingTable::iterator it = rtable.find(destAddr);
-    if (it == rtable.end()) {
-        EV << "address " << destAddr << " unreachable, discarding packet " << pk->getName() << endl;
-        emit(dropSignal, (intval_t)pk->getByteLength());
+    bool timeLookup = lookupTimingInterval > 0 && --lookupCountdown == 0;
+    std::chrono::steady_clock::time_point lookupStart;
+    if (timeLookup)
+        lookupStart = std::chrono::steady_clock::now();
+
+    int outGateIndex;
+    if (routingDatabase)
+        outGateIndex = routingDatabase->getNextHop(myNodeIndex, destAddr);
+    else if (areaSize > 0 && destAddr / areaSize != myArea) {
+        // destination in another area: a division and one array index
+        int destArea = destAddr / areaSize;
+        outGateIndex = destAddr >= 0 && destArea < (int)areaNextHops.size() ? areaNextHops[destArea] : (int)RoutingEngine::NO_ROUTE;
+    }
+    else if (adaptiveRouting) {
+        // loads are refreshed at most once per loadUpdateInterval, so the
+        // per-packet cost is a table lookup plus a scan of up to 4 gates
+        if (simTime() - lastLoadUpdate >= loadUpdateInterval)
+            updateGateLoads();
+        outGateIndex = rtable.lookupLeastLoaded(destAddr, gateLoads.data());
+    }
+    else {
+        outGateIndex = ecmp ? rtable.lookup(destAddr, flowHash(pk->getSrcAddr(), destAddr)) : rtable.lookup(destAddr);
+        if (outGateIndex == NextHopTable::UNKNOWN)
+            outGateIndex = resolveRoute(destAddr);
+    }
+
+    if (timeLookup) {
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - lookupStart).count();
+        numLookupSamples++;
+        lookupTimeSum += ns;
+        lookupTimeMax = std::max(lookupTimeMax, ns);
+        lookupCountdown = lookupTimingInterval;
+    }
+
+    if (outGateIndex == RoutingEngine::NO_ROUTE) {
+        HOT_EV << "address " << destAddr << " unreachable, discarding packet " << pk->getName() << endl;
+        if ((signalMask & DROP) && mayHaveListeners(dropSignal))
+            emit(dropSignal, (intval_t)pk->getByteLength());
+        dropCounters.count(pk->getByteLength());
+        if (resultStream)
+            resultStream->record(simTime().dbl(), streamSourceId, dropMetricId, pk->getByteLength());
         delete pk;
         return;
     }
 
-    int outGateIndex = (*it).second;
-    EV << "forwarding packet " << pk->getName() << " on gate index " << outGateIndex << endl;
+    // ✅ CHANGE: Per-packet log lines are skipped entirely in fastMode
+    // ✔️ IMPACT: No stream formatting or getName() calls on every hop in batch runs
+    HOT_EV << "forwarding packet " << pk->getName() << " on gate index " << outGateIndex << endl;
     pk->setHopCount(pk->getHopCount() + 1);
-    emit(outputIfSignal, outGateIndex);
+    if ((signalMask & OUTPUT_IF) && mayHaveListeners(outputIfSignal))
+        emit(outputIfSignal, outGateIndex);
+    portCounters[outGateIndex].count(pk->getByteLength());
+    if (resultStream)
+        resultStream->record(simTime().dbl(), streamSourceId, outputIfMetricId, outGateIndex);
+
+    send(pk, outGates[outGateIndex]);
+}
+
+void Routing::finish()
+{
+    if (aggregateStats) {
+        // ✅ CHANGE: Per-hop outputIf values are aggregated into counters
+        // ✔️ IMPACT: A handful of scalars per router instead of a vector entry per hop
+        recordScalar("outputIf[local]:count", localCounters.packets);
+        char name[32];
+        for (size_t i = 0; i < portCounters.size(); i++) {
+            snprintf(name, sizeof(name), "outputIf[%d]:count", (int)i);
+            recordScalar(name, portCounters[i].packets);
+        }
+        recordScalar("drop:count", dropCounters.packets);
+        recordScalar("drop:sum", dropCounters.bytes, "B");
+    }
 
-    send(pk, "out", outGateIndex);
+    if (numRouteUpdates > 0) {
+        recordScalar("routeUpdates:processed", numRouteUpdates);
+        recordScalar("routeUpdates:duplicates", numDuplicateRouteUpdates);
+    }
+
+    if (recordPortCounters) {
+        char name[40];
+        for (size_t i = 0; i < portCounters.size(); i++) {
+            snprintf(name, sizeof(name), "port[%d]:peerAddress", (int)i);
+            recordScalar(name, portPeerAddresses[i]);
+            snprintf(name, sizeof(name), "port[%d]:packets", (int)i);
+            recordScalar(name, portCounters[i].packets);
+            snprintf(name, sizeof(name), "port[%d]:bytes", (int)i);
+            recordScalar(name, portCounters[i].bytes, "B");
+        }
+        recordScalar("local:packets", localCounters.packets);
+        recordScalar("local:bytes", localCounters.bytes, "B");
+        recordScalar("dropped:packets", dropCounters.packets);
+        recordScalar("dropped:bytes", dropCounters.bytes, "B");
+    }
+    if (numLookupSamples > 0) {
+        recordScalar("lookupTime:samples", numLookupSamples);
+        recordScalar("lookupTime:mean", lookupTimeSum / numLookupSamples * 1e-9, "s");
+        recordScalar("lookupTime:max", lookupTimeMax * 1e-9, "s");
+    }
+
+    if (profiler) {
+        // ✅ CHANGE: Startup profile -- time per phase summed over all
+        // routers, path computations, and table memory per router and in total
+        // ✔️ IMPACT: Startup regressions show up per phase in the scalars,
+        // across topology sizes and routing modes
+        recordScalar("routingTable:bytes", getTableMemoryUsage(), "B");
+        if (profiler->claimRecording()) {
+            // once per partition, by the first router to finish
+            if (engine)
+                profiler->noteEngine(engine);
+            recordScalar("routingProfile:routers", profiler->getNumRouters());
+            recordScalar("routingProfile:ready", profiler->getNumReady());
+            recordScalar("routingProfile:extractTime", profiler->getPhaseTime(RoutingProfiler::EXTRACT), "s");
+            recordScalar("routingProfile:computeTime", profiler->getPhaseTime(RoutingProfiler::COMPUTE), "s");
+            recordScalar("routingProfile:tableFillTime", profiler->getPhaseTime(RoutingProfiler::TABLE_FILL), "s");
+            recordScalar("routingProfile:disseminationTime", profiler->getPhaseTime(RoutingProfiler::DISSEMINATION), "s");
+            recordScalar("routingProfile:pathComputations", profiler->getNumPathComputations());
+            recordScalar("routingProfile:tableMemory:total", profiler->getTableBytesTotal(), "B");
+            recordScalar("routingProfile:tableMemory:max", profiler->getTableBytesMax(), "B");
+            if (profiler->getNumReady() > 0)
+                recordScalar("routingProfile:tableMemory:mean", (double)profiler->getTableBytesTotal() / profiler->getNumReady(), "B");
+            recordScalar("routingProfile:sharedMemory:peak", profiler->getSharedBytesPeak(), "B");
+            recordScalar("routingProfile:peakRss", RoutingProfiler::getPeakRss(), "B");
+            if (!profiler->isReported()) {
+                // inband routes that never reached every router
+                std::cout << profiler->getSummary() << std::endl;
+                profiler->setReported();
+            }
+        }
+    }
+
+    if (dynamicRouting) {
+        dynamicRouting->setListener(myNodeIndex, nullptr);
+        DynamicRouting::release();
+        dynamicRouting = nullptr;
+    }
+    releaseTopology();
 }
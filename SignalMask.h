@@ -0,0 +1,37 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#ifndef __SIGNAL_MASK_H
+#define __SIGNAL_MASK_H
+
+#include <cstring>
+#include <omnetpp.h>
+
+/**
+ * Resolves once, at initialization, which of a module's signals are
+ * emitted. Bit i of the result is set if collect is true and names[i]
+ * appears in the space-separated enabledSignals list ("*" enables all).
+ * Modules test the bit, and mayHaveListeners() for the signal, before
+ * computing and emitting a value.
+ */
+inline unsigned resolveSignalMask(bool collect, const char *enabledSignals, const char *const names[], int numNames)
+{
+    if (!collect)
+        return 0;
+    unsigned mask = 0;
+    omnetpp::cStringTokenizer tokenizer(enabledSignals);
+    while (const char *token = tokenizer.nextToken()) {
+        for (int i = 0; i < numNames; i++)
+            if (!strcmp(token, "*") || !strcmp(token, names[i]))
+                mask |= 1u << i;
+    }
+    return mask;
+}
+
+#endif
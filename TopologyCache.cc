@@ -0,0 +1,223 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#include <fstream>
+#include <sstream>
+#include "TopologyCache.h"
+
+std::map<TopologyCache::Key, TopologyCache::Entry> TopologyCache::entries;
+std::map<cModule *, TopologyCache::Graph> TopologyCache::graphs;
+
+TopologyCache::LinkMetric TopologyCache::parseLinkMetric(const char *s)
+{
+    if (!strcmp(s, "hops"))
+        return METRIC_HOPS;
+    else if (!strcmp(s, "delay"))
+        return METRIC_DELAY;
+    else if (!strcmp(s, "datarate"))
+        return METRIC_DATARATE;
+    else if (!strcmp(s, "combined"))
+        return METRIC_COMBINED;
+    throw cRuntimeError("Invalid routingMetric '%s', must be hops, delay, datarate or combined", s);
+}
+
+double TopologyCache::getLinkCost(cGate *gate, LinkMetric metric, int packetLength)
+{
+    if (metric == METRIC_HOPS)
+        return 1;
+
+    simtime_t delay = SIMTIME_ZERO;
+    double datarate = 0;  // 0: infinite
+    cChannel *channel = gate->getChannel();
+    if (cDatarateChannel *datarateChannel = dynamic_cast<cDatarateChannel *>(channel)) {
+        delay = datarateChannel->getDelay();
+        datarate = datarateChannel->getDatarate();
+    }
+    else if (cDelayChannel *delayChannel = dynamic_cast<cDelayChannel *>(channel))
+        delay = delayChannel->getDelay();
+
+    // a tiny per-hop cost keeps zero-cost links from producing long paths,
+    // and acts as a hop count tie-breaker between equal-cost paths
+    const double hopCost = 1e-12;
+    switch (metric) {
+        case METRIC_DELAY:
+            return delay.dbl() + hopCost;
+        case METRIC_DATARATE:
+            return (datarate > 0 ? 1 / datarate : 0) + hopCost;
+        case METRIC_COMBINED:
+            return delay.dbl() + (datarate > 0 ? 8.0 * packetLength / datarate : 0) + hopCost;
+        default:
+            return 1;
+    }
+}
+
+RoutingEngine *TopologyCache::extract(const char *nedTypeName, LinkMetric metric, int packetLength)
+{
+    cTopology topo("topo");
+    std::vector<std::string> nedTypes;
+    nedTypes.push_back(nedTypeName);
+    topo.extractByNedTypeName(nedTypes);
+    EV << "cTopology found " << topo.getNumNodes() << " nodes\n";
+
+    std::map<cTopology::Node *, int> nodeIndex;
+    std::vector<int> addresses;
+    for (int i = 0; i < topo.getNumNodes(); i++) {
+        nodeIndex[topo.getNode(i)] = i;
+        addresses.push_back(topo.getNode(i)->getModule()->par("address"));
+    }
+
+    std::vector<RoutingEngine::Link> links;
+    for (int i = 0; i < topo.getNumNodes(); i++) {
+        cTopology::Node *node = topo.getNode(i);
+        for (int j = 0; j < node->getNumOutLinks(); j++) {
+            cTopology::LinkOut *link = node->getLinkOut(j);
+            cGate *gate = link->getLocalGate();
+            links.push_back({i, nodeIndex[link->getRemoteNode()], gate->getIndex(), getLinkCost(gate, metric, packetLength)});
+        }
+    }
+
+    RoutingEngine *engine = new RoutingEngine();
+    engine->build(addresses, links);
+    return engine;
+}
+
+RoutingEngine *TopologyCache::buildFromGraph(const Graph& graph, LinkMetric metric, int packetLength)
+{
+    std::vector<RoutingEngine::Link> links = graph.links;
+    if (metric != METRIC_HOPS)
+        for (size_t i = 0; i < links.size(); i++)
+            links[i].weight = getLinkCost(graph.gates[i], metric, packetLength);
+    EV << "Using the generated graph: " << graph.addresses.size() << " nodes, " << links.size() << " links\n";
+
+    RoutingEngine *engine = new RoutingEngine();
+    engine->build(graph.addresses, links);
+    return engine;
+}
+
+void TopologyCache::registerGraph(cModule *network, const char *nedTypeName, const std::vector<int>& addresses,
+                                  const std::vector<RoutingEngine::Link>& links, const std::vector<cGate *>& gates)
+{
+    Graph& graph = graphs[network];
+    graph.nedTypeName = nedTypeName;
+    graph.addresses = addresses;
+    graph.links = links;
+    graph.gates = gates;
+}
+
+void TopologyCache::unregisterGraph(cModule *network)
+{
+    graphs.erase(network);
+}
+
+const RoutingEngine *TopologyCache::acquire(cModule *node, LinkMetric metric, int packetLength)
+{
+    std::string name = std::string(node->getNedTypeName()) + "|" + std::to_string(metric);
+    if (metric == METRIC_COMBINED)
+        name += "|" + std::to_string(packetLength);
+    cModule *network = node->getSimulation()->getSystemModule();
+    Key key(network, name);
+    Entry& entry = entries[key];
+    if (!entry.engine) {
+        auto graph = graphs.find(network);
+        if (graph != graphs.end() && graph->second.nedTypeName == node->getNedTypeName())
+            entry.engine = buildFromGraph(graph->second, metric, packetLength);
+        else
+            entry.engine = extract(node->getNedTypeName(), metric, packetLength);
+    }
+    entry.numUsers++;
+    return entry.engine;
+}
+
+const RoutingEngine *TopologyCache::acquireFromFile(cModule *node, const char *fileName)
+{
+    Key key(node->getSimulation()->getSystemModule(), std::string("file:") + fileName);
+    Entry& entry = entries[key];
+    if (!entry.engine)
+        entry.engine = readTopologyFile(fileName);
+    entry.numUsers++;
+    return entry.engine;
+}
+
+RoutingEngine *TopologyCache::readTopologyFile(const char *fileName)
+{
+    std::ifstream in(fileName);
+    if (!in)
+        throw cRuntimeError("Cannot open topology file '%s'", fileName);
+
+    std::vector<int> addresses;
+    std::map<int, int> addressToNode;
+    std::vector<std::pair<int, int>> linkAddresses;  // resolved once all nodes are known
+    std::vector<RoutingEngine::Link> links;
+    std::string line;
+    for (int lineNumber = 1; std::getline(in, line); lineNumber++) {
+        std::istringstream tokens(line);
+        std::string keyword;
+        if (!(tokens >> keyword) || keyword[0] == '#')
+            continue;
+        if (keyword == "node") {
+            int address;
+            if (!(tokens >> address) || addressToNode.count(address))
+                throw cRuntimeError("%s:%d: invalid or duplicate node", fileName, lineNumber);
+            addressToNode[address] = addresses.size();
+            addresses.push_back(address);
+        }
+        else if (keyword == "link") {
+            int from, to, gateIndex;
+            double cost;
+            if (!(tokens >> from >> to >> gateIndex >> cost) || cost <= 0)
+                throw cRuntimeError("%s:%d: invalid link", fileName, lineNumber);
+            linkAddresses.push_back(std::make_pair(from, to));
+            links.push_back({-1, -1, gateIndex, cost});
+        }
+        else
+            throw cRuntimeError("%s:%d: unknown keyword '%s'", fileName, lineNumber, keyword.c_str());
+    }
+
+    for (size_t i = 0; i < links.size(); i++) {
+        auto from = addressToNode.find(linkAddresses[i].first);
+        auto to = addressToNode.find(linkAddresses[i].second);
+        if (from == addressToNode.end() || to == addressToNode.end())
+            throw cRuntimeError("%s: link %d -> %d refers to an undeclared node", fileName, linkAddresses[i].first, linkAddresses[i].second);
+        links[i].from = from->second;
+        links[i].to = to->second;
+    }
+    EV << "Topology file " << fileName << ": " << addresses.size() << " nodes, " << links.size() << " links\n";
+
+    RoutingEngine *engine = new RoutingEngine();
+    engine->build(addresses, links);
+    return engine;
+}
+
+void TopologyCache::exportTopology(const RoutingEngine *engine, const char *fileName)
+{
+    std::ofstream out(fileName);
+    if (!out)
+        throw cRuntimeError("Cannot open topology file '%s' for writing", fileName);
+    out.precision(17);
+    out << "# " << engine->getNumNodes() << " nodes, " << engine->getNumLinks() << " links\n";
+    for (int i = 0; i < engine->getNumNodes(); i++)
+        out << "node " << engine->getAddress(i) << "\n";
+    for (int i = 0; i < engine->getNumNodes(); i++)
+        for (int e = engine->getLinkBegin(i); e < engine->getLinkEnd(i); e++)
+            out << "link " << engine->getAddress(i) << " " << engine->getAddress(engine->getLinkTarget(e)) << " "
+                << engine->getLinkGate(e) << " " << engine->getLinkWeight(e) << "\n";
+}
+
+void TopologyCache::release(const RoutingEngine *engine)
+{
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->second.engine == engine) {
+            if (--it->second.numUsers == 0) {
+                delete it->second.engine;
+                entries.erase(it);
+            }
+            return;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#ifndef __TOPOLOGYCACHE_H
+#define __TOPOLOGYCACHE_H
+
+#include <map>
+#include <string>
+#include <omnetpp.h>
+#include "RoutingEngine.h"
+
+using namespace omnetpp;
+
+/**
+ * Shared, reference-counted topology extraction. The router graph of a
+ * network is extracted once per (network, NED type name, link metric) and
+ * handed out read-only to every Routing module; it is freed when the last
+ * user releases it.
+ *
+ * For parallel simulation, where a partition only has its own modules, the
+ * graph can also be read from a topology file, written by exportTopology()
+ * in a sequential run of the same network.
+ *
+ * Networks that are generated in C++ (see TopologyGenerator) register their
+ * graph when they build it; acquire() then builds the engine from it, and
+ * no cTopology extraction takes place.
+ */
+class TopologyCache
+{
+  public:
+    /** Link cost used for route computation; see the routingMetric NED parameter */
+    enum LinkMetric {
+        METRIC_HOPS,      // 1 per link
+        METRIC_DELAY,     // propagation delay
+        METRIC_DATARATE,  // 1/datarate
+        METRIC_COMBINED   // delay + transmission time of a reference packet
+    };
+
+  private:
+    struct Entry {
+        RoutingEngine *engine = nullptr;
+        int numUsers = 0;
+    };
+    typedef std::pair<cModule *, std::string> Key;  // network, NED type name + metric (or file name)
+    static std::map<Key, Entry> entries;
+
+    struct Graph {
+        std::string nedTypeName;
+        std::vector<int> addresses;
+        std::vector<RoutingEngine::Link> links;  // weights are filled in per metric
+        std::vector<cGate *> gates;              // output gate of each link, for the link costs
+    };
+    static std::map<cModule *, Graph> graphs;  // network -> registered graph
+
+  protected:
+    static RoutingEngine *extract(const char *nedTypeName, LinkMetric metric, int packetLength);
+    static RoutingEngine *readTopologyFile(const char *fileName);
+    static RoutingEngine *buildFromGraph(const Graph& graph, LinkMetric metric, int packetLength);
+    static double getLinkCost(cGate *gate, LinkMetric metric, int packetLength);
+
+  public:
+    /**
+     * Returns the routing engine for the network of the given node module,
+     * extracting the topology of all modules of the same NED type when
+     * called for the first time. Link costs are derived from the channels
+     * according to the metric; packetLength (bytes) is only used by
+     * METRIC_COMBINED. Every call must be paired with release().
+     */
+    static const RoutingEngine *acquire(cModule *node, LinkMetric metric = METRIC_HOPS, int packetLength = 0);
+    static void release(const RoutingEngine *engine);
+
+    /**
+     * Like acquire(), but reads the graph (including link costs) from the
+     * given topology file instead of walking the modules of the network.
+     */
+    static const RoutingEngine *acquireFromFile(cModule *node, const char *fileName);
+
+    /**
+     * Writes the graph to a text file, with one "node <address>" line per
+     * node and one "link <from> <to> <gateIndex> <cost>" line per link
+     * (addresses, output gate index at the "from" node).
+     */
+    static void exportTopology(const RoutingEngine *engine, const char *fileName);
+
+    /**
+     * Registers the graph of a network built in C++, for the nodes of the
+     * given NED type: node addresses, links between node indices (with the
+     * output gate index at the "from" node), and the output gate of every
+     * link, from which the link costs are derived. The graph is used by
+     * acquire() until unregisterGraph() is called.
+     */
+    static void registerGraph(cModule *network, const char *nedTypeName, const std::vector<int>& addresses,
+                              const std::vector<RoutingEngine::Link>& links, const std::vector<cGate *>& gates);
+    static void unregisterGraph(cModule *network);
+
+    static LinkMetric parseLinkMetric(const char *s);
+};
+
+#endif
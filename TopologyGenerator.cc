@@ -0,0 +1,276 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <omnetpp.h>
+#include "RoutingEngine.h"
+#include "TopologyCache.h"
+
+using namespace omnetpp;
+
+/**
+ * Generated network; see NED file for more info.
+ */
+class TopologyGenerator : public cModule
+{
+  private:
+    typedef std::vector<std::pair<int, int>> EdgeList;  // undirected, node indices
+
+    cRNG *rng = nullptr;
+    bool graphRegistered = false;
+
+  public:
+    virtual ~TopologyGenerator();
+
+  protected:
+    virtual void doBuildInside() override;
+
+    // graph generators; nodes are numbered from 0, edges are not repeated
+    virtual int generateGrid(int numNodes, int width, EdgeList& edges);
+    virtual int generateFatTree(int k, bool hosts, EdgeList& edges);
+    virtual int generateErdosRenyi(int numNodes, double meanDegree, EdgeList& edges);
+    virtual int generateScaleFree(int numNodes, int linksPerNode, EdgeList& edges);
+    virtual void connectComponents(int numNodes, EdgeList& edges);
+};
+
+Define_Module(TopologyGenerator);
+
+TopologyGenerator::~TopologyGenerator()
+{
+    if (graphRegistered)
+        TopologyCache::unregisterGraph(this);
+}
+
+int TopologyGenerator::generateGrid(int numNodes, int width, EdgeList& edges)
+{
+    if (width <= 0)
+        width = std::max(1, (int)std::lround(std::sqrt((double)numNodes)));
+    int height = std::max(1, numNodes / width);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int node = y * width + x;
+            if (x + 1 < width)
+                edges.push_back(std::make_pair(node, node + 1));
+            if (y + 1 < height)
+                edges.push_back(std::make_pair(node, node + width));
+        }
+    }
+    return width * height;
+}
+
+int TopologyGenerator::generateFatTree(int k, bool hosts, EdgeList& edges)
+{
+    // k-ary fat tree: (k/2)^2 core switches, then per pod k/2 aggregation
+    // and k/2 edge switches, then (optionally) k/2 hosts per edge switch
+    if (k < 2 || k % 2 != 0)
+        throw cRuntimeError("fatTreeK must be even and at least 2");
+    int half = k / 2;
+    int numCore = half * half;
+    int firstPod = numCore;
+    int numSwitches = numCore + k * k;
+    int next = numSwitches;
+    for (int pod = 0; pod < k; pod++) {
+        int firstAggregation = firstPod + pod * k;
+        int firstEdge = firstAggregation + half;
+        for (int a = 0; a < half; a++) {
+            for (int c = 0; c < half; c++)
+                edges.push_back(std::make_pair(firstAggregation + a, a * half + c));
+            for (int e = 0; e < half; e++)
+                edges.push_back(std::make_pair(firstAggregation + a, firstEdge + e));
+        }
+        if (hosts)
+            for (int e = 0; e < half; e++)
+                for (int h = 0; h < half; h++)
+                    edges.push_back(std::make_pair(firstEdge + e, next++));
+    }
+    return next;
+}
+
+int TopologyGenerator::generateErdosRenyi(int numNodes, double meanDegree, EdgeList& edges)
+{
+    // G(n,p) in O(n + m): the gaps between the pairs (v,w), w < v, that
+    // become edges are geometrically distributed (Batagelj & Brandes)
+    double p = numNodes > 1 ? std::min(1.0, meanDegree / (numNodes - 1)) : 0;
+    if (p <= 0)
+        return numNodes;
+    edges.reserve((size_t)(p * numNodes * (numNodes - 1) / 2 * 1.05) + 16);
+    if (p >= 1) {
+        for (int v = 1; v < numNodes; v++)
+            for (int w = 0; w < v; w++)
+                edges.push_back(std::make_pair(v, w));
+        return numNodes;
+    }
+    double logQ = std::log(1 - p);
+    int64_t v = 1, w = -1;
+    while (v < numNodes) {
+        w += 1 + (int64_t)std::floor(std::log(1 - rng->doubleRand()) / logQ);
+        while (w >= v && v < numNodes) {
+            w -= v;
+            v++;
+        }
+        if (v < numNodes)
+            edges.push_back(std::make_pair((int)v, (int)w));
+    }
+    return numNodes;
+}
+
+int TopologyGenerator::generateScaleFree(int numNodes, int linksPerNode, EdgeList& edges)
+{
+    // Barabasi-Albert preferential attachment: a clique of linksPerNode+1
+    // nodes, then every new node links to linksPerNode distinct nodes picked
+    // with probability proportional to their degree, i.e. uniformly from the
+    // list of edge endpoints
+    int m = linksPerNode;
+    if (m < 1)
+        throw cRuntimeError("scaleFreeLinks must be at least 1");
+    int numSeed = std::min(numNodes, m + 1);
+    std::vector<int> endpoints;
+    endpoints.reserve(2 * (size_t)m * numNodes);
+    for (int v = 0; v < numSeed; v++) {
+        for (int w = 0; w < v; w++) {
+            edges.push_back(std::make_pair(v, w));
+            endpoints.push_back(v);
+            endpoints.push_back(w);
+        }
+    }
+    std::vector<int> targets;
+    for (int v = numSeed; v < numNodes; v++) {
+        targets.clear();
+        while ((int)targets.size() < m) {
+            int target = endpoints[rng->intRand(endpoints.size())];
+            if (std::find(targets.begin(), targets.end(), target) == targets.end())
+                targets.push_back(target);
+        }
+        for (int target : targets) {
+            edges.push_back(std::make_pair(v, target));
+            endpoints.push_back(v);
+            endpoints.push_back(target);
+        }
+    }
+    return numNodes;
+}
+
+void TopologyGenerator::connectComponents(int numNodes, EdgeList& edges)
+{
+    // union-find over the edges, then one link from a random node of every
+    // further component to a random node of the part connected so far
+    std::vector<int> parent(numNodes);
+    for (int i = 0; i < numNodes; i++)
+        parent[i] = i;
+    auto find = [&](int x) {
+        while (parent[x] != x)
+            x = parent[x] = parent[parent[x]];
+        return x;
+    };
+    for (const auto& edge : edges)
+        parent[find(edge.first)] = find(edge.second);
+
+    std::vector<std::vector<int>> components;
+    std::vector<int> componentOf(numNodes, -1);
+    for (int i = 0; i < numNodes; i++) {
+        int root = find(i);
+        if (componentOf[root] == -1) {
+            componentOf[root] = components.size();
+            components.push_back(std::vector<int>());
+        }
+        components[componentOf[root]].push_back(i);
+    }
+    std::vector<int> connected = components.empty() ? std::vector<int>() : components[0];
+    for (size_t c = 1; c < components.size(); c++) {
+        const std::vector<int>& component = components[c];
+        edges.push_back(std::make_pair(component[rng->intRand(component.size())], connected[rng->intRand(connected.size())]));
+        connected.insert(connected.end(), component.begin(), component.end());
+    }
+    if (components.size() > 1)
+        EV << "connected " << components.size() << " components with " << components.size() - 1 << " extra links\n";
+}
+
+void TopologyGenerator::doBuildInside()
+{
+    cModule::doBuildInside();  // whatever the NED type declares
+    rng = getRNG(0);
+
+    // ✅ CHANGE: The graph is generated in memory, and nodes and links are
+    // created from it in one pass, with every port vector sized up front
+    // ✔️ IMPACT: Networks of 100k nodes are built without a topology file,
+    // and without gate vector resizing per connection
+    const char *topology = par("topology").stringValue();
+    int numNodes = par("numNodes").intValue();
+    EdgeList edges;
+    if (!strcmp(topology, "grid"))
+        numNodes = generateGrid(numNodes, par("gridWidth").intValue(), edges);
+    else if (!strcmp(topology, "fattree"))
+        numNodes = generateFatTree(par("fatTreeK").intValue(), par("fatTreeHosts").boolValue(), edges);
+    else if (!strcmp(topology, "erdosrenyi"))
+        numNodes = generateErdosRenyi(numNodes, par("meanDegree").doubleValue(), edges);
+    else if (!strcmp(topology, "scalefree"))
+        numNodes = generateScaleFree(numNodes, par("scaleFreeLinks").intValue(), edges);
+    else
+        throw cRuntimeError("Invalid topology '%s', must be grid, fattree, erdosrenyi or scalefree", topology);
+    if (numNodes < 1)
+        throw cRuntimeError("Generated topology has no nodes");
+    if (par("connected").boolValue())
+        connectComponents(numNodes, edges);
+
+    // port indices: the links of a node are numbered in edge list order
+    std::vector<int> degrees(numNodes, 0);
+    std::vector<std::pair<int, int>> ports(edges.size());  // port at (first, second)
+    for (size_t i = 0; i < edges.size(); i++)
+        ports[i] = std::make_pair(degrees[edges[i].first]++, degrees[edges[i].second]++);
+    for (int degree : degrees)
+        if (degree > INT16_MAX)
+            throw cRuntimeError("Node degree %d exceeds the supported number of ports", degree);
+
+    // nodes are named "rte<address>", like the NetBuilder networks
+    cModuleType *nodeType = cModuleType::get(par("nodeType").stringValue());
+    std::vector<cModule *> nodes(numNodes);
+    char name[32];
+    for (int i = 0; i < numNodes; i++) {
+        snprintf(name, sizeof(name), "rte%d", i);
+        cModule *node = nodeType->create(name, this);
+        node->par("address").setIntValue(i);
+        node->finalizeParameters();
+        node->setGateSize("port", degrees[i]);
+        node->buildInside();
+        nodes[i] = node;
+    }
+
+    double datarate = par("datarate").doubleValue();
+    double delay = par("delay").doubleValue();
+    std::vector<int> addresses(numNodes);
+    for (int i = 0; i < numNodes; i++)
+        addresses[i] = i;
+    std::vector<RoutingEngine::Link> links;
+    std::vector<cGate *> linkGates;
+    links.reserve(2 * edges.size());
+    linkGates.reserve(2 * edges.size());
+    for (size_t i = 0; i < edges.size(); i++) {
+        int a = edges[i].first, b = edges[i].second;
+        int portA = ports[i].first, portB = ports[i].second;
+        for (int direction = 0; direction < 2; direction++) {
+            cGate *out = nodes[a]->gate("port$o", portA);
+            cDatarateChannel *channel = cDatarateChannel::create("channel");
+            channel->setDatarate(datarate);
+            channel->setDelay(delay);
+            out->connectTo(nodes[b]->gate("port$i", portB), channel, true);  // initialized with the network
+            links.push_back({a, b, portA});
+            linkGates.push_back(out);
+            std::swap(a, b);
+            std::swap(portA, portB);
+        }
+    }
+    EV << "Generated " << topology << " topology: " << numNodes << " nodes, " << edges.size() << " links\n";
+
+    // ✅ CHANGE: The graph goes to the routers as it is, instead of being
+    // rediscovered with cTopology::extractByNedTypeName()
+    // ✔️ IMPACT: No extraction pass over the modules at startup
+    TopologyCache::registerGraph(this, nodeType->getFullName(), addresses, links, linkGates);
+    graphRegistered = true;
+}
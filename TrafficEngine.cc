@@ -0,0 +1,180 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#include <algorithm>
+#include <map>
+#include "TrafficEngine.h"
+
+static std::string trim(const std::string& s)
+{
+    size_t begin = s.find_first_not_of(" \t\r\n");
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return begin == std::string::npos ? "" : s.substr(begin, end - begin + 1);
+}
+
+// parses a constant quantity, e.g. "2ms" or "50 bytes", into the given unit
+static double parseArgument(const std::string& text, const char *targetUnit, std::string& unit)
+{
+    double value = cValue::parseQuantity(text.c_str(), unit);
+    if (unit.empty() || !targetUnit || !*targetUnit)
+        return value;
+    return cValue::convertUnit(value, unit.c_str(), targetUnit);
+}
+
+bool TrafficSampler::compile(cPar *parameter, cRNG *moduleRng, size_t blockSize)
+{
+    setParameter(parameter);
+    rng = moduleRng;
+
+    const char *targetUnit = par->getUnit();
+    std::string expr = trim(par->str());
+    try {
+        size_t open = expr.find('(');
+        if (open == std::string::npos) {
+            std::string unit;
+            a = parseArgument(expr, targetUnit, unit);
+            kind = CONSTANT;
+        }
+        else if (expr.back() == ')' && expr.find('(', open + 1) == std::string::npos) {
+            std::string name = trim(expr.substr(0, open));
+            std::vector<std::string> args;
+            std::string inner = expr.substr(open + 1, expr.size() - open - 2);
+            for (size_t pos = 0; pos <= inner.size(); ) {
+                size_t comma = std::min(inner.find(',', pos), inner.size());
+                args.push_back(trim(inner.substr(pos, comma - pos)));
+                pos = comma + 1;
+            }
+            std::string unitA, unitB;
+            if (args.size() == 1 && name == "exponential") {
+                a = parseArgument(args[0], targetUnit, unitA);
+                kind = EXPONENTIAL;
+            }
+            else if (args.size() == 2 && name == "intuniform") {
+                // integers in the unit of the arguments, e.g. intuniform(15ms, 40ms)
+                a = cValue::parseQuantity(args[0].c_str(), unitA);
+                b = cValue::parseQuantity(args[1].c_str(), unitB);
+                if (unitA == unitB) {
+                    scale = unitA.empty() || !targetUnit || !*targetUnit ? 1 : cValue::convertUnit(1, unitA.c_str(), targetUnit);
+                    kind = INTUNIFORM;
+                }
+            }
+            else if (args.size() == 2 && (name == "uniform" || name == "normal" || name == "truncnormal")) {
+                a = parseArgument(args[0], targetUnit, unitA);
+                b = parseArgument(args[1], targetUnit, unitB);
+                kind = name == "uniform" ? UNIFORM : name == "normal" ? NORMAL : TRUNCNORMAL;
+            }
+        }
+    }
+    catch (std::exception&) {
+        kind = PARAMETER;  // not a constant expression, e.g. it refers to other parameters
+    }
+
+    if (blockSize > 0) {
+        block.resize(blockSize);
+        blockPos = blockSize;  // filled on the first draw
+    }
+    return kind != PARAMETER;
+}
+
+double TrafficSampler::drawOne()
+{
+    switch (kind) {
+        case CONSTANT: return a;
+        case UNIFORM: return uniform(rng, a, b);
+        case INTUNIFORM: return intuniform(rng, (int)a, (int)b) * scale;
+        case EXPONENTIAL: return exponential(rng, a);
+        case NORMAL: return normal(rng, a, b);
+        case TRUNCNORMAL: return truncnormal(rng, a, b);
+        default: return intPar ? (double)par->intValue() : par->doubleValue();
+    }
+}
+
+void TrafficSampler::refill()
+{
+    for (double& value : block)
+        value = drawOne();
+    blockPos = 0;
+}
+
+std::string TrafficSampler::str() const
+{
+    static const char *const names[] = { "parameter", "constant", "uniform", "intuniform", "exponential", "normal", "truncnormal" };
+    std::string s = std::string(names[kind]) + " sampler for " + par->getName() + " = " + par->str();
+    if (!block.empty())
+        s += ", blocks of " + std::to_string(block.size());
+    return s;
+}
+
+void DestinationSampler::build(const std::vector<int>& destAddresses, const std::vector<double>& weights)
+{
+    // Vose's construction: slots with less than the average weight are
+    // topped up from a slot with more, which becomes their alias
+    int n = destAddresses.size();
+    addresses = destAddresses;
+    probabilities.assign(n, 1);
+    aliases.resize(n);
+    double sum = 0;
+    for (double weight : weights)
+        sum += weight;
+    std::vector<double> scaled(n);
+    std::vector<int> small, large;
+    for (int i = 0; i < n; i++) {
+        aliases[i] = i;
+        scaled[i] = weights[i] * n / sum;
+        (scaled[i] < 1 ? small : large).push_back(i);
+    }
+    while (!small.empty() && !large.empty()) {
+        int s = small.back(), l = large.back();
+        small.pop_back();
+        probabilities[s] = scaled[s];
+        aliases[s] = l;
+        scaled[l] -= 1 - scaled[s];
+        if (scaled[l] < 1) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // leftovers are 1 up to rounding errors
+}
+
+void parseTrafficMatrix(const char *text, int srcAddress, std::vector<int>& dests, std::vector<double>& weights)
+{
+    std::map<int, double> row;
+    std::string s(text);
+    for (size_t pos = 0; pos < s.size(); ) {
+        size_t end = std::min(s.find_first_of(";\n", pos), s.size());
+        std::string entry = s.substr(pos, end - pos);
+        pos = end + 1;
+        entry = trim(entry.substr(0, entry.find('#')));
+        if (entry.empty())
+            continue;
+
+        char src[32];
+        int dest;
+        double weight;
+        char rest;
+        if (sscanf(entry.c_str(), "%31s %d %lf %c", src, &dest, &weight, &rest) != 3 || weight < 0)
+            throw cRuntimeError("Invalid traffic matrix entry '%s', expected '<src> <dest> <weight>'", entry.c_str());
+        char *srcEnd;
+        long srcValue = strtol(src, &srcEnd, 10);
+        if (strcmp(src, "*") != 0 && (*srcEnd || srcEnd == src))
+            throw cRuntimeError("Invalid source '%s' in traffic matrix entry '%s'", src, entry.c_str());
+        if ((!strcmp(src, "*") || srcValue == srcAddress) && dest != srcAddress)
+            row[dest] += weight;
+    }
+
+    dests.clear();
+    weights.clear();
+    for (const auto& entry : row) {
+        if (entry.second > 0) {
+            dests.push_back(entry.first);
+            weights.push_back(entry.second);
+        }
+    }
+}
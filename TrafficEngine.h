@@ -0,0 +1,115 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+#ifndef __TRAFFIC_ENGINE_H
+#define __TRAFFIC_ENGINE_H
+
+#include <string>
+#include <vector>
+#include <omnetpp.h>
+
+using namespace omnetpp;
+
+/**
+ * Native sampler for a volatile parameter of a traffic generator. The
+ * parameter's expression is compiled once: constants and the common
+ * distributions of our ini files -- uniform(a,b), intuniform(a,b),
+ * exponential(mean), normal(mean,stddev), truncnormal(mean,stddev), with
+ * constant arguments -- are drawn directly from the module's RNG, in the
+ * parameter's unit. Anything else is still evaluated through the
+ * parameter on every draw.
+ *
+ * Optionally, values are generated in blocks of blockSize draws, so the
+ * sampler runs in a tight loop and a draw is usually a buffer read. With
+ * blocks, the RNG is consumed in a different order, so the values differ
+ * from those of unblocked draws (but follow the same distribution).
+ */
+class TrafficSampler
+{
+  public:
+    enum Kind { PARAMETER, CONSTANT, UNIFORM, INTUNIFORM, EXPONENTIAL, NORMAL, TRUNCNORMAL };
+
+  private:
+    Kind kind = PARAMETER;
+    double a = 0, b = 0;
+    double scale = 1;  // intuniform: unit of the arguments, in the parameter's unit
+    cPar *par = nullptr;
+    bool intPar = false;
+    cRNG *rng = nullptr;
+    std::vector<double> block;
+    size_t blockPos = 0;
+
+    double drawOne();
+    void refill();
+
+  public:
+    /**
+     * Compiles the expression of the given parameter. Returns false if the
+     * expression is not supported; the sampler then falls back to
+     * evaluating the parameter. blockSize = 0 disables block generation.
+     */
+    bool compile(cPar *par, cRNG *rng, size_t blockSize = 0);
+
+    /** Draws by evaluating the parameter, without compiling it. */
+    void setParameter(cPar *parameter) {
+        par = parameter;
+        intPar = par->getType() == cPar::INT;
+        kind = PARAMETER;
+        block.clear();
+    }
+
+    double draw() {
+        if (block.empty())
+            return drawOne();
+        if (blockPos == block.size())
+            refill();
+        return block[blockPos++];
+    }
+
+    Kind getKind() const { return kind; }
+
+    /** Describes the compiled sampler, for logging. */
+    std::string str() const;
+};
+
+/**
+ * Weighted choice of a destination address in O(1) per draw, with Walker's
+ * alias method: one RNG draw picks a slot, and a compare selects the
+ * slot's address or its alias.
+ */
+class DestinationSampler
+{
+  private:
+    std::vector<int> addresses;
+    std::vector<double> probabilities;  // of keeping the slot's own address
+    std::vector<int> aliases;           // slot index
+
+  public:
+    /** Weights must be non-negative, with a positive sum. */
+    void build(const std::vector<int>& addresses, const std::vector<double>& weights);
+
+    bool isEmpty() const { return addresses.empty(); }
+    int getNumDestinations() const { return addresses.size(); }
+
+    int draw(cRNG *rng) const {
+        double u = rng->doubleRand() * addresses.size();
+        int slot = (int)u;
+        return u - slot < probabilities[slot] ? addresses[slot] : addresses[aliases[slot]];
+    }
+};
+
+/**
+ * Reads the row of a traffic matrix for the given source address. The text
+ * holds "<src> <dest> <weight>" entries separated by ';' or newlines ('#'
+ * starts a comment); src may be "*" for every source. Entries with the same
+ * destination are summed. Throws cRuntimeError on syntax errors.
+ */
+void parseTrafficMatrix(const char *text, int srcAddress, std::vector<int>& dests, std::vector<double>& weights);
+
+#endif
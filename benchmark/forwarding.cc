@@ -0,0 +1,257 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+// Per-hop cost of the forwarding paths of Routing, without the simulation
+// kernel: the work handleMessage() does for a transit packet is replayed on
+// a stream of packets, with the real NextHopTable and small stand-ins for
+// the kernel calls involved:
+//
+//   before  Routing_before.cc: check_and_cast, std::map lookup, hop count,
+//           emit() with a listener check, send() by gate name and index
+//   general Routing_after.cc with fastDataPlane = false and statisticsMode =
+//           "aggregated": kind check, check_and_cast, NextHopTable lookup,
+//           lookup timing countdown, signal mask checks, port counters,
+//           send() by gate name and index
+//   fast    fastDataPlane = true: kind check, static_cast, NextHopTable
+//           lookup, hop count, port counters, send() on a cached gate pointer
+//
+// The gate lookup by name is modeled after cModule::gate(): a scan of the
+// gate descriptors with a name compare, then an index check. send() itself
+// is the same in all three (the packet is appended to the gate's queue), so
+// the differences are the per-hop overhead the fast path removes.
+//
+//   c++ -O3 -march=native -std=c++17 -I. benchmark/forwarding.cc NextHopTable.cc -o forwarding
+//   ./forwarding [--destinations 1000] [--ports 8] [--hops 20000000] [--json results.json]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "NextHopTable.h"
+
+namespace {
+
+enum { ROUTING_CONTROL = 100 };
+
+struct Message {
+    short kind = 0;
+    virtual ~Message() {}
+};
+
+struct Packet : Message {
+    int srcAddr = 0;
+    int destAddr = 0;
+    int hopCount = 0;
+    int64_t byteLength = 1500;
+};
+
+template <typename T>
+T *check_and_cast(Message *msg)
+{
+    T *result = dynamic_cast<T *>(msg);
+    if (!result)
+        throw std::runtime_error("cannot cast");
+    return result;
+}
+
+struct Gate {
+    std::vector<Message *> queue;
+};
+
+struct GateDesc {
+    const char *name;
+    std::vector<Gate> gates;
+};
+
+struct RouterModel {
+    int myAddress = -1;
+    std::vector<GateDesc> gateDescs;  // in[], out[], localIn, localOut, like Routing
+    std::vector<Gate *> outGates;
+    std::map<int, int> mapTable;
+    NextHopTable rtable;
+    std::vector<uint64_t> portPackets, portBytes;
+    bool hasListeners = false;
+    int64_t emitted = 0;
+    unsigned signalMask = 0;
+    int lookupTimingInterval = 0, lookupCountdown = 0;
+    void *resultStream = nullptr;
+
+    RouterModel(int numPorts, const std::vector<std::pair<int, int>>& routes) {
+        for (const char *name : { "in", "out", "localIn", "localOut" })
+            gateDescs.push_back(GateDesc { name, std::vector<Gate>(strncmp(name, "local", 5) ? numPorts : 1) });
+        for (Gate& gate : gateDescs[1].gates)
+            outGates.push_back(&gate);
+        for (const auto& route : routes)
+            mapTable[route.first] = route.second;
+        rtable.build(routes);
+        portPackets.assign(numPorts, 0);
+        portBytes.assign(numPorts, 0);
+    }
+
+    Gate *gate(const char *name, int index) {
+        for (GateDesc& desc : gateDescs)
+            if (!strcmp(desc.name, name)) {
+                if (index < 0 || index >= (int)desc.gates.size())
+                    throw std::runtime_error("gate index out of range");
+                return &desc.gates[index];
+            }
+        throw std::runtime_error("no such gate");
+    }
+
+    void emit(intptr_t value) {
+        if (hasListeners)
+            emitted += value;
+    }
+
+    static void send(Message *msg, Gate *gate) { gate->queue.push_back(msg); }
+
+    void forwardBefore(Message *msg) {
+        Packet *pk = check_and_cast<Packet>(msg);
+        int destAddr = pk->destAddr;
+        if (destAddr == myAddress)
+            return;
+        auto it = mapTable.find(destAddr);
+        if (it == mapTable.end())
+            return;
+        int outGateIndex = it->second;
+        pk->hopCount++;
+        emit(outGateIndex);
+        send(pk, gate("out", outGateIndex));
+    }
+
+    void forwardGeneral(Message *msg) {
+        if (msg->kind == ROUTING_CONTROL)
+            return;
+        Packet *pk = check_and_cast<Packet>(msg);
+        int destAddr = pk->destAddr;
+        if (destAddr == myAddress)
+            return;
+        bool timeLookup = lookupTimingInterval > 0 && --lookupCountdown == 0;
+        int outGateIndex = rtable.lookup(destAddr);
+        if (timeLookup)
+            lookupCountdown = lookupTimingInterval;
+        if (outGateIndex < 0)
+            return;
+        pk->hopCount++;
+        if (signalMask && hasListeners)
+            emit(outGateIndex);
+        portPackets[outGateIndex]++;
+        portBytes[outGateIndex] += pk->byteLength;
+        if (resultStream)
+            return;
+        send(pk, gate("out", outGateIndex));
+    }
+
+    void forwardFast(Message *msg) {
+        if (msg->kind == ROUTING_CONTROL)
+            return;
+        Packet *pk = static_cast<Packet *>(msg);
+        int destAddr = pk->destAddr;
+        int outGateIndex = rtable.lookup(destAddr);
+        if (outGateIndex >= 0 && destAddr != myAddress) {
+            pk->hopCount++;
+            portPackets[outGateIndex]++;
+            portBytes[outGateIndex] += pk->byteLength;
+            send(pk, outGates[outGateIndex]);
+        }
+    }
+
+    void clearQueues() {
+        for (Gate *gate : outGates)
+            gate->queue.clear();
+    }
+};
+
+template <typename Fn>
+double timePerHop(RouterModel& router, std::vector<Packet>& packets, long numHops, Fn forward)
+{
+    // packets are forwarded in batches of the stream size, and the queues
+    // are emptied in between (outside the timed region), so send() stays a
+    // push into reserved memory
+    for (Gate *gate : router.outGates)
+        gate->queue.reserve(packets.size());
+    double total = 0;
+    for (long done = 0; done < numHops; done += packets.size()) {
+        router.clearQueues();
+        auto start = std::chrono::steady_clock::now();
+        for (Packet& pk : packets)
+            forward(router, &pk);
+        total += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+    long roundedHops = (numHops + packets.size() - 1) / packets.size() * packets.size();
+    return total / roundedHops;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    int numDestinations = 1000;
+    int numPorts = 8;
+    long numHops = 20000000;
+    std::string jsonFile;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--destinations") && i + 1 < argc)
+            numDestinations = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--ports") && i + 1 < argc)
+            numPorts = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--hops") && i + 1 < argc)
+            numHops = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonFile = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--destinations n] [--ports n] [--hops n] [--json file]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (numDestinations < 1 || numPorts < 1 || numPorts > 32767 || numHops < 1) {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    std::mt19937 rng(1);
+    std::vector<std::pair<int, int>> routes;
+    for (int address = 0; address < numDestinations; address++)
+        routes.push_back(std::make_pair(address, std::uniform_int_distribution<int>(0, numPorts - 1)(rng)));
+    RouterModel router(numPorts, routes);
+
+    std::vector<Packet> packets(65536);
+    std::uniform_int_distribution<int> dest(0, numDestinations - 1);
+    for (Packet& pk : packets) {
+        pk.srcAddr = dest(rng);
+        pk.destAddr = dest(rng);
+    }
+
+    double before = timePerHop(router, packets, numHops, [](RouterModel& r, Message *msg) { r.forwardBefore(msg); });
+    double general = timePerHop(router, packets, numHops, [](RouterModel& r, Message *msg) { r.forwardGeneral(msg); });
+    double fast = timePerHop(router, packets, numHops, [](RouterModel& r, Message *msg) { r.forwardFast(msg); });
+
+    printf("%-12s %8s %12s\n", "path", "ns/hop", "vs before");
+    printf("%-12s %8.2f %12.2f\n", "before", before, 1.0);
+    printf("%-12s %8.2f %12.2f\n", "general", general, before / general);
+    printf("%-12s %8.2f %12.2f\n", "fast", fast, before / fast);
+
+    if (!jsonFile.empty()) {
+        FILE *f = fopen(jsonFile.c_str(), "w");
+        if (!f) {
+            perror(jsonFile.c_str());
+            return 1;
+        }
+        fprintf(f, "{\"destinations\": %d, \"ports\": %d, \"hops\": %ld, \"before_ns\": %g, \"general_ns\": %g, \"fast_ns\": %g}\n",
+                numDestinations, numPorts, numHops, before, general, fast);
+        fclose(f);
+    }
+    return 0;
+}
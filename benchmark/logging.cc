@@ -0,0 +1,218 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+// Per-packet cost of the log statements of Routing and BurstyApp, without
+// the simulation kernel: the statements a packet passes through -- "next
+// sending in" and "generating packet" at the source, "forwarding packet" at
+// every hop, "received packet" at the sink -- are replayed with a stand-in
+// for the EV macro of the kernel:
+//
+//   EV << a << b;   expands to   (!enabled(this) ? dummyStream : logStream) << a << b;
+//
+// so even when the predicate says no, every argument is evaluated and
+// inserted into the (failed) dummy stream: getName() calls, integer
+// insertions, and simtime formatting, which happens before the stream
+// state is checked. Three modes are timed:
+//
+//   logging   Cmdenv without express mode: the lines are formatted into a
+//             log buffer (discarded here, so no I/O is measured)
+//   express   Cmdenv express mode, logging disabled: the predicate is false,
+//             the arguments are still evaluated
+//   fastMode  HOT_EV with fastMode = true: one branch per statement
+//
+//   c++ -O3 -march=native -std=c++17 benchmark/logging.cc -o logging
+//   ./logging [--hops 5] [--packets 5000000] [--json results.json]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// simtime_t stand-in: int64 count of picoseconds, printed like SimTime::ttoa()
+struct SimTime {
+    int64_t raw;
+};
+
+const char *ttoa(char *buf, int64_t t, int scaleExp, char *&endp)
+{
+    // digits from the end of the buffer, with the decimal point inserted
+    // at -scaleExp digits and trailing zeros of the fraction dropped
+    endp = buf + 63;
+    *endp = 0;
+    char *s = endp;
+    bool negative = t < 0;
+    uint64_t value = negative ? -(uint64_t)t : (uint64_t)t;
+    bool skipZeros = true;
+    int digits = 0;
+    do {
+        int digit = value % 10;
+        value /= 10;
+        if (skipZeros && digit == 0 && digits < -scaleExp) {
+            digits++;
+            continue;
+        }
+        skipZeros = false;
+        *--s = '0' + digit;
+        if (++digits == -scaleExp)
+            *--s = '.';
+    } while (value || digits < -scaleExp + 1);
+    if (*s == '.')
+        *--s = '0';
+    if (negative)
+        *--s = '-';
+    return s;
+}
+
+std::ostream& operator<<(std::ostream& os, const SimTime& x)
+{
+    char buf[64];
+    char *endp;
+    return os << ttoa(buf, x.raw, -12, endp);
+}
+
+// like cNamedObject: never null
+struct Packet {
+    const char *name = nullptr;
+    int srcAddr = 0, destAddr = 0, hopCount = 0;
+    const char *getName() const { return name ? name : ""; }
+};
+
+std::ostream dummyStream(nullptr);  // badbit set, like cLogProxy's dummy stream
+
+struct LogBuffer : std::stringbuf {
+    int sync() override {
+        str(std::string());  // the line would go to the log here
+        return 0;
+    }
+};
+LogBuffer logBuffer;
+std::ostream logStream(&logBuffer);
+
+// runtime logging predicate of the environment, behind a function pointer
+struct Component {
+    int logLevel = 0;
+};
+bool loggingEnabled = false;
+bool componentPredicate(const Component *component, int level)
+{
+    return loggingEnabled && level >= component->logLevel;
+}
+bool (*volatile runtimeLoggingPredicate)(const Component *, int) = componentPredicate;
+
+#define EV (!runtimeLoggingPredicate(this, 1) ? dummyStream : logStream)
+#define HOT_EV if (fastMode) ; else EV
+
+struct Module : Component {
+    bool fastMode = false;
+    int myAddress = 7;
+    int pkCounter = 0;
+
+    // the log statements of one packet's life, as in BurstyApp_after.cc
+    // and Routing_after.cc
+    void generate(Packet *pk, SimTime d) {
+        HOT_EV << "next sending in " << d << "s\n";
+        HOT_EV << "generating packet pk-" << myAddress << "-to-" << pk->destAddr << "-#" << pkCounter << std::endl;
+        pkCounter++;
+    }
+    void forward(Packet *pk, int outGateIndex) {
+        HOT_EV << "forwarding packet " << pk->getName() << " on gate index " << outGateIndex << std::endl;
+        pk->hopCount++;
+    }
+    void receive(Packet *pk) {
+        HOT_EV << "received packet " << pk->getName() << " from " << pk->srcAddr << " after " << pk->hopCount << "hops" << std::endl;
+    }
+};
+
+double timePerPacket(Module& module, std::vector<Packet>& packets, int hops, long numPackets)
+{
+    int64_t t = 1234567890;
+    auto start = std::chrono::steady_clock::now();
+    for (long done = 0; done < numPackets; done += packets.size()) {
+        for (Packet& pk : packets) {
+            pk.hopCount = 0;
+            t += 987654321;
+            module.generate(&pk, SimTime { t });
+            for (int h = 0; h < hops; h++)
+                module.forward(&pk, (pk.destAddr + h) & 7);
+            module.receive(&pk);
+        }
+    }
+    double total = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    long roundedPackets = (numPackets + packets.size() - 1) / packets.size() * packets.size();
+    return total / roundedPackets;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    int hops = 5;
+    long numPackets = 5000000;
+    std::string jsonFile;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--hops") && i + 1 < argc)
+            hops = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--packets") && i + 1 < argc)
+            numPackets = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonFile = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--hops n] [--packets n] [--json file]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (hops < 0 || numPackets < 1) {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    // named packets, as with packetNames = "always" (the before variant)
+    std::vector<Packet> packets(4096);
+    std::vector<std::string> names(packets.size());
+    for (size_t i = 0; i < packets.size(); i++) {
+        packets[i].srcAddr = 7;
+        packets[i].destAddr = i % 60;
+        names[i] = "pk-7-to-" + std::to_string(packets[i].destAddr) + "-#" + std::to_string(i);
+        packets[i].name = names[i].c_str();
+    }
+
+    Module module;
+    loggingEnabled = true;
+    double logging = timePerPacket(module, packets, hops, numPackets / 10 + 1);
+    loggingEnabled = false;
+    double express = timePerPacket(module, packets, hops, numPackets);
+    module.fastMode = true;
+    double fast = timePerPacket(module, packets, hops, numPackets);
+
+    int statements = hops + 3;
+    printf("%d hops, %d log statements per packet\n", hops, statements);
+    printf("%-10s %12s %14s\n", "mode", "ns/packet", "ns/statement");
+    printf("%-10s %12.2f %14.2f\n", "logging", logging, logging / statements);
+    printf("%-10s %12.2f %14.2f\n", "express", express, express / statements);
+    printf("%-10s %12.2f %14.2f\n", "fastMode", fast, fast / statements);
+
+    if (!jsonFile.empty()) {
+        FILE *f = fopen(jsonFile.c_str(), "w");
+        if (!f) {
+            perror(jsonFile.c_str());
+            return 1;
+        }
+        fprintf(f, "{\"hops\": %d, \"packets\": %ld, \"logging_ns\": %g, \"express_ns\": %g, \"fast_mode_ns\": %g}\n",
+                hops, numPackets, logging, express, fast);
+        fclose(f);
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+//
+// This file is part of an OMNeT++/OMNEST simulation example.
+//
+// Copyright (C) 1992-2015 Andras Varga
+//
+// This file is distributed WITHOUT ANY WARRANTY. See the file
+// `license' for details on this and other legal matters.
+//
+
+// Compares the kernels of RoutingEngine::computeAllNextHops() (one BFS per
+// source, and bit-parallel BFS over batches of destinations) on synthetic
+// graphs: "mesh" (a square grid, like the Mesh network), "randommesh" (a
+// grid with 25% of the links removed, like RandomMesh) and "random" (a
+// random tree plus random links, 4 links per node on average). RoutingEngine
+// does not depend on the simulation kernel, so no OMNeT++ is needed:
+//
+//   c++ -O3 -march=native -std=c++17 -I. benchmark/route_kernels.cc RoutingEngine.cc -o route_kernels -lpthread
+//   ./route_kernels [--sizes 1000,5000,10000] [--threads 1] [--json results.json]
+//
+// Every run also checks on sampled (source, destination) pairs that both
+// matrices yield paths of the same hop count.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "RoutingEngine.h"
+
+struct GraphBuilder {
+    std::vector<int> addresses;
+    std::vector<RoutingEngine::Link> links;
+    std::vector<int> numPorts;
+
+    explicit GraphBuilder(int numNodes) : numPorts(numNodes, 0) {
+        for (int i = 0; i < numNodes; i++)
+            addresses.push_back(i);
+    }
+
+    void connect(int a, int b) {
+        RoutingEngine::Link link;
+        link.from = a;
+        link.to = b;
+        link.gateIndex = numPorts[a]++;
+        links.push_back(link);
+        link.from = b;
+        link.to = a;
+        link.gateIndex = numPorts[b]++;
+        links.push_back(link);
+    }
+};
+
+static void buildGraph(const std::string& type, int size, std::mt19937& rng, RoutingEngine& engine)
+{
+    int side = (int)std::lround(std::sqrt((double)size));
+    int numNodes = type == "random" ? size : side * side;
+    GraphBuilder graph(numNodes);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    if (type == "random") {
+        for (int i = 1; i < numNodes; i++)
+            graph.connect(i, std::uniform_int_distribution<int>(0, i - 1)(rng));
+        for (int k = 0; k < numNodes; k++) {
+            int a = std::uniform_int_distribution<int>(0, numNodes - 1)(rng);
+            int b = std::uniform_int_distribution<int>(0, numNodes - 1)(rng);
+            if (a != b)
+                graph.connect(a, b);
+        }
+    }
+    else {
+        double keep = type == "randommesh" ? 0.75 : 1.0;
+        for (int y = 0; y < side; y++) {
+            for (int x = 0; x < side; x++) {
+                int node = y * side + x;
+                if (x + 1 < side && uniform(rng) < keep)
+                    graph.connect(node, node + 1);
+                if (y + 1 < side && uniform(rng) < keep)
+                    graph.connect(node, node + side);
+            }
+        }
+    }
+    engine.build(graph.addresses, graph.links);
+}
+
+static int pathLength(const RoutingEngine& engine, const std::vector<int16_t>& matrix, int source, int dest)
+{
+    int numNodes = engine.getNumNodes();
+    int hops = 0;
+    for (int node = source; node != dest; hops++) {
+        int gateIndex = matrix[(size_t)node * numNodes + dest];
+        if (gateIndex == RoutingEngine::NO_ROUTE || hops > numNodes)
+            return -1;
+        int next = -1;
+        for (int e = engine.getLinkBegin(node); e < engine.getLinkEnd(node); e++)
+            if (engine.getLinkGate(e) == gateIndex)
+                next = engine.getLinkTarget(e);
+        node = next;
+    }
+    return hops;
+}
+
+static double timeKernel(const RoutingEngine& engine, std::vector<int16_t>& matrix, int numThreads, RoutingEngine::Kernel kernel)
+{
+    auto start = std::chrono::steady_clock::now();
+    engine.computeAllNextHops(matrix.data(), numThreads, kernel);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    std::string sizes = "1000,5000,10000";
+    std::string jsonFile;
+    int numThreads = 1;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--sizes") && i + 1 < argc)
+            sizes = argv[++i];
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            numThreads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonFile = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--sizes n1,n2,...] [--threads n] [--json file]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<std::string> rows;
+    printf("%-12s %8s %8s %12s %12s %8s %10s\n", "graph", "nodes", "links", "bfs_s", "bitset_s", "speedup", "mismatch");
+    for (const char *type : { "mesh", "randommesh", "random" }) {
+        for (size_t pos = 0; pos < sizes.size(); ) {
+            size_t end = sizes.find(',', pos);
+            if (end == std::string::npos)
+                end = sizes.size();
+            int size = atoi(sizes.substr(pos, end - pos).c_str());
+            pos = end + 1;
+
+            std::mt19937 rng(size);
+            RoutingEngine engine;
+            buildGraph(type, size, rng, engine);
+            int numNodes = engine.getNumNodes();
+            std::vector<int16_t> scalar((size_t)numNodes * numNodes), bitset((size_t)numNodes * numNodes);
+            double scalarTime = timeKernel(engine, scalar, numThreads, RoutingEngine::PER_SOURCE);
+            double bitsetTime = timeKernel(engine, bitset, numThreads, RoutingEngine::BITSET_BFS);
+
+            int mismatches = 0;
+            std::uniform_int_distribution<int> node(0, numNodes - 1);
+            for (int k = 0; k < 1000; k++) {
+                int source = node(rng), dest = node(rng);
+                if (pathLength(engine, scalar, source, dest) != pathLength(engine, bitset, source, dest))
+                    mismatches++;
+            }
+
+            printf("%-12s %8d %8d %12.4f %12.4f %8.2f %10d\n", type, numNodes, engine.getNumLinks(),
+                   scalarTime, bitsetTime, scalarTime / bitsetTime, mismatches);
+            char row[256];
+            snprintf(row, sizeof(row),
+                     "{\"graph\": \"%s\", \"nodes\": %d, \"links\": %d, \"threads\": %d, \"bfs_s\": %g, \"bitset_s\": %g, \"mismatches\": %d}",
+                     type, numNodes, engine.getNumLinks(), numThreads, scalarTime, bitsetTime, mismatches);
+            rows.push_back(row);
+        }
+    }
+
+    if (!jsonFile.empty()) {
+        FILE *f = fopen(jsonFile.c_str(), "w");
+        if (!f) {
+            perror(jsonFile.c_str());
+            return 1;
+        }
+        fprintf(f, "[\n");
+        for (size_t i = 0; i < rows.size(); i++)
+            fprintf(f, "  %s%s\n", rows[i].c_str(), i + 1 < rows.size() ? "," : "");
+        fprintf(f, "]\n");
+        fclose(f);
+    }
+    return 0;
+}
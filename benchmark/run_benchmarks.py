@@ -0,0 +1,306 @@
+#!/usr/bin/env python3
+"""
+Benchmark harness for the _before and _after variants of the routing
+example.
+
+For each variant, a build directory is assembled under --work-dir: the
+OMNeT++ routing sample (networks, Node, App, L2Queue, Packet.msg) is taken
+from --sample-dir, and the files of this repository are copied over it,
+with the _before/_after suffix stripped (Routing_after.cc -> Routing.cc,
+omnetpp_after.ini -> omnetpp.ini, ...). The directory is built with
+opp_makemake in release mode, and every config is run in Cmdenv.
+
+Measured per run:
+  init_time_s      network setup and initialize(), up to "Running simulation..."
+  run_time_s       event loop, up to "Calling finish()"
+  events, events_per_sec
+  peak_rss_kb      maximum resident set size of the simulation process
+  forwarded        packets routed, from the outputIf histogram counts (or
+                   the outputIf[*]:count scalars of statisticsMode = "aggregated")
+  ns_per_forward   run_time_s / forwarded
+  routing_profile  the routingProfile:* scalars of the after variant
+                   (profileRouting = true): seconds per startup phase, path
+                   computations, table and shared memory in bytes
+
+Scaled topologies use the Mesh and RandomGraph networks, and generated
+scale-free networks (GeneratedNetwork), with the sizes from --sizes (e.g.
+100,1000,10000 nodes). The summary is written as JSON to --output and
+printed as a table.
+
+With --route-kernels, benchmark/route_kernels.cc is also compiled and run
+(no OMNeT++ needed); it times the all-pairs route computation kernels
+(per-source BFS vs bitset BFS) on synthetic graphs of the --sizes node
+counts, and its results are added to the summary.
+
+  benchmark/run_benchmarks.py --sample-dir $OMNETPP_ROOT/samples/routing
+  benchmark/run_benchmarks.py --variants after --configs Mesh --sizes 100,2500,10000
+With --forwarding, benchmark/forwarding.cc (no OMNeT++ needed either)
+times the per-hop work of the forwarding paths -- before, the general path
+of after, and the fastDataPlane path -- and reports ns per hop.
+
+With --logging, benchmark/logging.cc (no OMNeT++ needed) times the log
+statements a packet passes through, with logging on, in express mode (EV
+arguments still evaluated) and with fastMode, and reports ns per packet;
+the after variant also runs Net60BurstyFast, and the events/sec of
+Net60Bursty (before, after) and Net60BurstyFast (after) are added to the
+summary.
+
+  benchmark/run_benchmarks.py --variants "" --route-kernels --sizes 1000,5000,10000
+  benchmark/run_benchmarks.py --variants after --configs Net60ForwardingGeneral,Net60FastDataPlane --forwarding
+  benchmark/run_benchmarks.py --configs Net60Bursty --sizes "" --logging
+"""
+
+import argparse
+import glob
+import json
+import math
+import os
+import re
+import shutil
+import subprocess
+import sys
+import time
+
+REPO_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+DEFAULT_CONFIGS = ["Net5", "Net10", "Net60CutThrough", "Net60StoreAndForward", "Net60Bursty",
+                   "Mesh", "RandomMesh", "NetBuilder"]
+
+EXECUTABLE = "routing_bench"
+
+
+def stage_variant(variant, sample_dir, work_dir):
+    """Assembles the source tree of one variant; returns its directory."""
+    variant_dir = os.path.join(work_dir, variant)
+    if os.path.isdir(variant_dir):
+        shutil.rmtree(variant_dir)
+    shutil.copytree(sample_dir, variant_dir,
+                    ignore=shutil.ignore_patterns("out", "results", "*.o", "*_m.cc", "*_m.h", "Makefile"))
+    other = "before" if variant == "after" else "after"
+    for path in glob.glob(os.path.join(REPO_DIR, "*")):
+        name = os.path.basename(path)
+        if not os.path.isfile(path) or not re.search(r"\.(cc|h|msg|ned|ini)$", name):
+            continue
+        if "_" + other + "." in name:
+            continue
+        shutil.copy(path, os.path.join(variant_dir, name.replace("_" + variant + ".", ".")))
+    return variant_dir
+
+
+def build_variant(variant_dir, jobs):
+    subprocess.check_call(["opp_makemake", "-f", "--deep", "-o", EXECUTABLE], cwd=variant_dir)
+    subprocess.check_call(["make", "MODE=release", "-j%d" % jobs], cwd=variant_dir)
+
+
+def write_bench_ini(variant_dir, sizes):
+    """Writes bench.ini: omnetpp.ini plus scaled Mesh/RandomGraph configs."""
+    lines = ["include omnetpp.ini", ""]
+    scaled = []
+    for n in sizes:
+        side = int(round(math.sqrt(n)))
+        name = "BenchMesh%d" % (side * side)
+        lines += ["[%s]" % name, "extends = Mesh", "*.width = %d" % side, "*.height = %d" % side, ""]
+        scaled.append((name, side * side))
+        name = "BenchRandomGraph%d" % n
+        # about 4 links per node, so large graphs stay sparse
+        connectedness = min(0.5, 4.0 / n)
+        lines += ["[%s]" % name, "extends = RandomGraph", "*.n = %d" % n, "*.connectedness = %g" % connectedness, ""]
+        scaled.append((name, n))
+        # generated in C++ (TopologyGenerator), with the graph handed to the
+        # routers; the before variant extracts it with cTopology as usual
+        name = "BenchScaleFree%d" % n
+        lines += ["[%s]" % name, "network = node.GeneratedNetwork", '*.topology = "scalefree"', "*.numNodes = %d" % n,
+                  '**.destAddresses = "0 1 2"', ""]
+        scaled.append((name, n))
+    with open(os.path.join(variant_dir, "bench.ini"), "w") as f:
+        f.write("\n".join(lines))
+    return scaled
+
+
+def count_forwarded(sca_file):
+    """Sums the outputIf histogram counts (or aggregated outputIf[*]:count
+    scalars), and counts the routers."""
+    forwarded, routers = 0, 0
+    in_output_if = False
+    with open(sca_file) as f:
+        for line in f:
+            if line.startswith("statistic "):
+                in_output_if = line.split()[2].startswith("outputIf")
+                routers += in_output_if
+            elif in_output_if and line.startswith("field count "):
+                forwarded += int(float(line.split()[2]))
+            elif line.startswith("scalar "):
+                fields = line.split()
+                if re.match(r"outputIf\[(\d+|local)\]:count$", fields[2]):
+                    forwarded += int(float(fields[3]))
+                    routers += fields[2] == "outputIf[local]:count"
+    return forwarded, routers
+
+
+def read_profile(sca_file):
+    """Collects the routingProfile:* scalars (profileRouting = true), with
+    the prefix stripped, e.g. {"extractTime": 0.12, ...}."""
+    profile = {}
+    with open(sca_file) as f:
+        for line in f:
+            fields = line.split()
+            if line.startswith("scalar ") and len(fields) >= 4 and fields[2].startswith("routingProfile:"):
+                profile[fields[2][len("routingProfile:"):]] = float(fields[3])
+    return profile
+
+
+def run_config(variant_dir, config, sim_time, cpu_time_limit):
+    result_dir = os.path.join(variant_dir, "results", config)
+    os.makedirs(result_dir, exist_ok=True)
+    cmd = ["./" + EXECUTABLE, "-u", "Cmdenv", "-f", "bench.ini", "-c", config, "-r", "0",
+           "-n", ".", "--cmdenv-express-mode=true", "--cmdenv-performance-display=false",
+           "--sim-time-limit=%s" % sim_time, "--cpu-time-limit=%ds" % cpu_time_limit,
+           "--result-dir=%s" % result_dir, "--**.routing.profileRouting=true"]  # unused by before
+    start = time.monotonic()
+    init_done = run_done = None
+    events = 0
+    proc = subprocess.Popen(cmd, cwd=variant_dir, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                            universal_newlines=True, bufsize=1)
+    output = []
+    for line in proc.stdout:
+        now = time.monotonic()
+        output.append(line)
+        if init_done is None and "Running simulation" in line:
+            init_done = now
+        if run_done is None and "Calling finish()" in line:
+            run_done = now
+        m = re.search(r"event #(\d+)", line)
+        if m:
+            events = int(m.group(1))
+    _, status, rusage = os.wait4(proc.pid, 0)
+    end = time.monotonic()
+    proc.stdout.close()
+
+    exit_code = os.WEXITSTATUS(status) if os.WIFEXITED(status) else -os.WTERMSIG(status)
+    result = {"config": config, "exit_code": exit_code, "peak_rss_kb": rusage.ru_maxrss,
+              "wall_time_s": end - start, "events": events}
+    if init_done is None or run_done is None:
+        result["error"] = "".join(output[-10:])
+        return result
+    result["init_time_s"] = init_done - start
+    result["run_time_s"] = run_done - init_done
+    result["events_per_sec"] = events / result["run_time_s"] if result["run_time_s"] > 0 else None
+    sca_files = glob.glob(os.path.join(result_dir, "*.sca"))
+    if sca_files:
+        forwarded, routers = count_forwarded(max(sca_files, key=os.path.getmtime))
+        result["forwarded"] = forwarded
+        result["nodes"] = routers
+        result["ns_per_forward"] = 1e9 * result["run_time_s"] / forwarded if forwarded else None
+        profile = read_profile(max(sca_files, key=os.path.getmtime))
+        if profile:
+            result["routing_profile"] = profile
+    return result
+
+
+def run_route_kernels(work_dir, sizes, jobs):
+    """Builds and runs the route kernel benchmark; returns its rows."""
+    os.makedirs(work_dir, exist_ok=True)
+    executable = os.path.join(work_dir, "route_kernels")
+    subprocess.check_call([os.environ.get("CXX", "c++"), "-O3", "-march=native", "-std=c++17", "-I", REPO_DIR,
+                           os.path.join(REPO_DIR, "benchmark", "route_kernels.cc"),
+                           os.path.join(REPO_DIR, "RoutingEngine.cc"), "-o", executable, "-lpthread"])
+    json_file = os.path.join(work_dir, "route_kernels.json")
+    subprocess.check_call([executable, "--sizes", ",".join(str(n) for n in sizes), "--threads", str(jobs),
+                           "--json", json_file])
+    with open(json_file) as f:
+        return json.load(f)
+
+
+def run_forwarding(work_dir):
+    """Builds and runs the per-hop forwarding benchmark; returns its result."""
+    os.makedirs(work_dir, exist_ok=True)
+    executable = os.path.join(work_dir, "forwarding")
+    subprocess.check_call([os.environ.get("CXX", "c++"), "-O3", "-march=native", "-std=c++17", "-I", REPO_DIR,
+                           os.path.join(REPO_DIR, "benchmark", "forwarding.cc"),
+                           os.path.join(REPO_DIR, "NextHopTable.cc"), "-o", executable])
+    json_file = os.path.join(work_dir, "forwarding.json")
+    subprocess.check_call([executable, "--json", json_file])
+    with open(json_file) as f:
+        return json.load(f)
+
+
+def run_logging(work_dir):
+    """Builds and runs the per-packet logging benchmark; returns its result."""
+    os.makedirs(work_dir, exist_ok=True)
+    executable = os.path.join(work_dir, "logging")
+    subprocess.check_call([os.environ.get("CXX", "c++"), "-O3", "-march=native", "-std=c++17",
+                           os.path.join(REPO_DIR, "benchmark", "logging.cc"), "-o", executable])
+    json_file = os.path.join(work_dir, "logging.json")
+    subprocess.check_call([executable, "--json", json_file])
+    with open(json_file) as f:
+        return json.load(f)
+
+
+def print_table(results):
+    columns = ["variant", "config", "nodes", "init_time_s", "events_per_sec", "peak_rss_kb", "ns_per_forward"]
+    print(" ".join("%-16s" % c for c in columns))
+    for r in results:
+        cells = []
+        for c in columns:
+            v = r.get(c)
+            cells.append("%-16s" % ("%.4g" % v if isinstance(v, float) else ("-" if v is None else v)))
+        print(" ".join(cells))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--sample-dir", default=os.path.join(os.environ.get("OMNETPP_ROOT", ""), "samples", "routing"),
+                        help="OMNeT++ routing sample providing networks/, Node, App, L2Queue")
+    parser.add_argument("--work-dir", default=os.path.join(REPO_DIR, "benchmark", "work"))
+    parser.add_argument("--variants", default="before,after")
+    parser.add_argument("--configs", default=",".join(DEFAULT_CONFIGS))
+    parser.add_argument("--sizes", default="100,1000,10000", help="node counts of the scaled topologies; empty for none")
+    parser.add_argument("--sim-time", default="10s")
+    parser.add_argument("--cpu-time-limit", type=int, default=600, help="per run, in seconds")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1)
+    parser.add_argument("--no-build", action="store_true", help="reuse the staged and built variants")
+    parser.add_argument("--route-kernels", action="store_true", help="also benchmark the route computation kernels")
+    parser.add_argument("--forwarding", action="store_true", help="also benchmark the per-hop forwarding paths")
+    parser.add_argument("--logging", action="store_true", help="also benchmark per-packet logging against fastMode")
+    parser.add_argument("--output", default=os.path.join(REPO_DIR, "benchmark", "results.json"))
+    args = parser.parse_args()
+
+    variants = [v for v in args.variants.split(",") if v]
+    if variants and not args.no_build and not os.path.isdir(os.path.join(args.sample_dir, "networks")):
+        sys.exit("routing sample not found at '%s', use --sample-dir" % args.sample_dir)
+    sizes = [int(s) for s in args.sizes.split(",") if s]
+    results = []
+    for variant in variants:
+        variant_dir = os.path.join(args.work_dir, variant)
+        if not args.no_build:
+            variant_dir = stage_variant(variant, args.sample_dir, args.work_dir)
+            build_variant(variant_dir, args.jobs)
+        scaled = write_bench_ini(variant_dir, sizes)
+        configs = args.configs.split(",")
+        if args.logging and variant == "after" and "Net60BurstyFast" not in configs:
+            configs.append("Net60BurstyFast")  # the fastMode counterpart of Net60Bursty
+        for config in configs + [name for name, _ in scaled]:
+            print("%s: running %s..." % (variant, config), file=sys.stderr)
+            result = run_config(variant_dir, config, args.sim_time, args.cpu_time_limit)
+            result["variant"] = variant
+            results.append(result)
+
+    summary = {"sim_time": args.sim_time, "sizes": sizes, "timestamp": time.strftime("%Y-%m-%dT%H:%M:%S"),
+               "results": results}
+    if args.route_kernels:
+        summary["route_kernels"] = run_route_kernels(args.work_dir, sizes, args.jobs)
+    if args.forwarding:
+        summary["forwarding"] = run_forwarding(args.work_dir)
+    if args.logging:
+        summary["logging"] = run_logging(args.work_dir)
+        summary["logging"]["events_per_sec"] = {
+            "%s:%s" % (r["variant"], r["config"]): r.get("events_per_sec")
+            for r in results if r["config"] in ("Net60Bursty", "Net60BurstyFast")}
+    with open(args.output, "w") as f:
+        json.dump(summary, f, indent=2)
+    print_table(results)
+    print("summary written to %s" % args.output, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""
+Converts a packet capture summary into the binary trace replayed by
+BurstyApp (traceFile parameter; see PacketTrace.h for the layout).
+
+The input is CSV with one packet per line: time (seconds), source
+address, destination address, length (bytes); lines starting with '#' and
+a header line are skipped. Records are sorted by (source, time), as the
+replay requires. Input larger than --chunk-records is sorted in runs that
+are merged at the end, so memory use stays bounded.
+
+    tools/mktrace.py capture.csv capture.trace
+    tools/mktrace.py --summary capture.trace
+"""
+
+import argparse
+import heapq
+import os
+import struct
+import sys
+import tempfile
+
+import numpy as np
+
+MAGIC = b"PKTRACE1"
+RECORD = np.dtype([("time", "<f8"), ("src", "<i4"), ("dest", "<i4"), ("length", "<u4"), ("reserved", "<u4")])
+HEADER = struct.Struct("<8sIIQ")
+
+
+def read_chunks(path, chunk_records):
+    """Yields record arrays of at most chunk_records parsed CSV lines."""
+    rows = []
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            fields = line.split(",")
+            try:
+                rows.append((float(fields[0]), int(fields[1]), int(fields[2]), int(fields[3]), 0))
+            except (ValueError, IndexError):
+                if rows:
+                    raise ValueError("invalid line: %r" % line)
+                continue  # header
+            if len(rows) == chunk_records:
+                yield np.array(rows, dtype=RECORD)
+                rows = []
+    if rows:
+        yield np.array(rows, dtype=RECORD)
+
+
+def sort_records(records):
+    return records[np.lexsort((records["time"], records["src"]))]
+
+
+def write_trace(path, num_records, blocks):
+    with open(path, "wb") as f:
+        f.write(HEADER.pack(MAGIC, RECORD.itemsize, 0, num_records))
+        for block in blocks:
+            f.write(block.tobytes())
+
+
+def merged_blocks(run_files, block_records=65536):
+    """k-way merge of sorted run files, yielded in blocks of records."""
+    def records(run):
+        data = np.memmap(run, dtype=RECORD, mode="r")
+        for start in range(0, len(data), block_records):
+            for r in data[start:start + block_records]:
+                yield (int(r["src"]), float(r["time"]), int(r["dest"]), int(r["length"]))
+    block = []
+    for r in heapq.merge(*[records(run) for run in run_files]):
+        block.append((r[1], r[0], r[2], r[3], 0))
+        if len(block) == block_records:
+            yield np.array(block, dtype=RECORD)
+            block = []
+    if block:
+        yield np.array(block, dtype=RECORD)
+
+
+def convert(csv_path, trace_path, chunk_records):
+    runs, total = [], 0
+    tmp_dir = tempfile.mkdtemp(prefix="mktrace-", dir=os.path.dirname(os.path.abspath(trace_path)))
+    try:
+        for chunk in read_chunks(csv_path, chunk_records):
+            run = os.path.join(tmp_dir, "run%d" % len(runs))
+            sort_records(chunk).tofile(run)
+            runs.append(run)
+            total += len(chunk)
+        if len(runs) <= 1:
+            blocks = [np.fromfile(runs[0], dtype=RECORD)] if runs else []
+        else:
+            blocks = merged_blocks(runs)
+        write_trace(trace_path, total, blocks)
+    finally:
+        for run in runs:
+            os.remove(run)
+        os.rmdir(tmp_dir)
+    return total
+
+
+def summary(trace_path):
+    with open(trace_path, "rb") as f:
+        magic, record_size, _, num_records = HEADER.unpack(f.read(HEADER.size))
+    if magic != MAGIC or record_size != RECORD.itemsize:
+        sys.exit("%s: not a packet trace" % trace_path)
+    records = np.memmap(trace_path, dtype=RECORD, mode="r", offset=HEADER.size, shape=(num_records,))
+    sources, starts = np.unique(records["src"], return_index=True)
+    ends = list(starts[1:]) + [num_records]
+    print("%d records, %d sources" % (num_records, len(sources)))
+    for src, start, end in zip(sources, starts, ends):
+        times = records["time"][start:end]
+        print("  src %d: %d records, %.6f .. %.6f s, %d bytes" %
+              (src, end - start, times[0], times[-1], records["length"][start:end].sum()))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", help="CSV capture, or the trace with --summary")
+    parser.add_argument("output", nargs="?")
+    parser.add_argument("--summary", action="store_true", help="print the per-source ranges of a trace")
+    parser.add_argument("--chunk-records", type=int, default=10000000, help="records sorted in memory at a time")
+    args = parser.parse_args()
+    if args.summary:
+        summary(args.input)
+    elif not args.output:
+        parser.error("output file required")
+    else:
+        n = convert(args.input, args.output, args.chunk_records)
+        print("%d records written to %s" % (n, args.output), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
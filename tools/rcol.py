@@ -0,0 +1,113 @@
+"""
+Reader for the columnar result files written by ResultStream
+(see ResultStream.h for the layout).
+
+    import rcol
+    res = rcol.load("results/Net10Experiment-0.rcol")
+    delays = res.metric("endToEndDelay")          # dict of numpy columns
+    df = res.to_dataframe()                       # all rows, with names
+
+The file is memory-mapped, and the columns of each chunk are numpy views
+into the mapping; only columns spanning several chunks are concatenated.
+"""
+
+import mmap
+import struct
+import sys
+
+import numpy as np
+
+MAGIC = b"ROUTCOL1"
+CHUNK_TAG = 0x4b4e4843
+DICT_TAG = 0x54434944
+
+
+class ResultFile:
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self._map = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        buf = self._map
+        if buf[:8] != MAGIC or buf[-8:] != MAGIC:
+            raise ValueError("%s: not a ROUTCOL1 file (or not closed properly)" % path)
+        (footer_offset,) = struct.unpack_from("<Q", buf, len(buf) - 16)
+        self.sources, self.metrics = self._read_footer(buf, footer_offset)
+        self.chunks = self._read_chunks(buf, footer_offset)
+
+    @staticmethod
+    def _read_strings(buf, offset):
+        (count,) = struct.unpack_from("<I", buf, offset)
+        offset += 4
+        strings = []
+        for _ in range(count):
+            (length,) = struct.unpack_from("<I", buf, offset)
+            offset += 4
+            strings.append(bytes(buf[offset:offset + length]).decode("utf-8"))
+            offset += length
+        return strings, offset
+
+    def _read_footer(self, buf, offset):
+        (tag,) = struct.unpack_from("<I", buf, offset)
+        if tag != DICT_TAG:
+            raise ValueError("corrupt footer")
+        sources, offset = self._read_strings(buf, offset + 4)
+        metrics, offset = self._read_strings(buf, offset)
+        return sources, metrics
+
+    def _read_chunks(self, buf, end):
+        chunks = []
+        offset = 8
+        while offset < end:
+            tag, n = struct.unpack_from("<II", buf, offset)
+            if tag != CHUNK_TAG:
+                raise ValueError("corrupt chunk at offset %d" % offset)
+            offset += 8
+            time = np.frombuffer(buf, "<f8", n, offset)
+            offset += 8 * n
+            source = np.frombuffer(buf, "<i4", n, offset)
+            offset += 4 * n
+            metric = np.frombuffer(buf, "<i4", n, offset)
+            offset += 4 * n
+            value = np.frombuffer(buf, "<f8", n, offset)
+            offset += 8 * n
+            chunks.append({"time": time, "source": source, "metric": metric, "value": value})
+        return chunks
+
+    def column(self, name):
+        """Returns one column over all chunks (a view if there is one chunk)."""
+        parts = [chunk[name] for chunk in self.chunks]
+        if not parts:
+            return np.empty(0, "<i4" if name in ("source", "metric") else "<f8")
+        return parts[0] if len(parts) == 1 else np.concatenate(parts)
+
+    def metric(self, name):
+        """Returns the time, source and value columns of one metric."""
+        if name not in self.metrics:
+            raise KeyError(name)
+        mask = self.column("metric") == self.metrics.index(name)
+        return {"time": self.column("time")[mask],
+                "source": self.column("source")[mask],
+                "value": self.column("value")[mask]}
+
+    def to_dataframe(self):
+        """Returns all rows as a pandas DataFrame with categorical names."""
+        import pandas as pd
+        return pd.DataFrame({
+            "time": self.column("time"),
+            "module": pd.Categorical.from_codes(self.column("source"), self.sources),
+            "metric": pd.Categorical.from_codes(self.column("metric"), self.metrics),
+            "value": self.column("value"),
+        })
+
+
+def load(path):
+    return ResultFile(path)
+
+
+if __name__ == "__main__":
+    for path in sys.argv[1:]:
+        res = load(path)
+        num_rows = sum(len(chunk["time"]) for chunk in res.chunks)
+        print("%s: %d rows in %d chunks, %d sources" % (path, num_rows, len(res.chunks), len(res.sources)))
+        metric_ids = res.column("metric")
+        for i, name in enumerate(res.metrics):
+            print("  %-20s %d rows" % (name, int((metric_ids == i).sum())))